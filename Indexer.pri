@@ -0,0 +1,37 @@
+#/*
+#* Copyright 2019 Rochus Keller <mailto:me@rochus-keller.ch>
+#*
+#* This file is part of the LolaCreator plugin.
+#*
+#* The following is the license that applies to this copy of the
+#* plugin. For a license to use the plugin under conditions
+#* other than those described here, please email to me@rochus-keller.ch.
+#*
+#* GNU General Public License Usage
+#* This file may be used under the terms of the GNU General Public
+#* License (GPL) versions 2.0 or 3.0 as published by the Free Software
+#* Foundation and appearing in the file LICENSE.GPL included in
+#* the packaging of this file. Please review the following information
+#* to ensure GNU General Public Licensing requirements will be met:
+#* http://www.fsf.org/licensing/licenses/info/GPLv2.html and
+#* http://www.gnu.org/copyleft/gpl.html.
+#*/
+
+# Project evaluation, file discovery and the span lexer with its scan kernels; QtCore and the Lola token table only,
+# shared by the plugin and lolaindex
+
+QT += concurrent
+
+INCLUDEPATH += $$PWD
+
+SOURCES += $$PWD/LlProjectFile.cpp \
+    $$PWD/LlDirScanner.cpp \
+    $$PWD/LlProjectLoader.cpp \
+    $$PWD/LlSpanLexer.cpp \
+    $$PWD/LlScanKernels.cpp
+
+HEADERS += $$PWD/LlProjectFile.h \
+    $$PWD/LlDirScanner.h \
+    $$PWD/LlProjectLoader.h \
+    $$PWD/LlSpanLexer.h \
+    $$PWD/LlScanKernels.h
@@ -0,0 +1,507 @@
+/*
+* Copyright 2019 Rochus Keller <mailto:me@rochus-keller.ch>
+*
+* This file is part of the LolaCreator plugin.
+*
+* The following is the license that applies to this copy of the
+* plugin. For a license to use the plugin under conditions
+* other than those described here, please email to me@rochus-keller.ch.
+*
+* GNU General Public License Usage
+* This file may be used under the terms of the GNU General Public
+* License (GPL) versions 2.0 or 3.0 as published by the Free Software
+* Foundation and appearing in the file LICENSE.GPL included in
+* the packaging of this file. Please review the following information
+* to ensure GNU General Public Licensing requirements will be met:
+* http://www.fsf.org/licensing/licenses/info/GPLv2.html and
+* http://www.gnu.org/copyleft/gpl.html.
+*/
+
+#include "LlBenchmark.h"
+#include "LlProjectLoader.h"
+#include "LlProjectFile.h"
+#include "LlDirScanner.h"
+#include "LlSpanLexer.h"
+#include "LlScanKernels.h"
+#include <Lola/LlCrossRefModel.h>
+#include <Lola/LlFileCache.h>
+#include <Lola/LlLexer.h>
+#include <QDir>
+#include <QFile>
+#include <QTextStream>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QStringMatcher>
+#include <QJsonArray>
+#include <QScopedPointer>
+#include <QHash>
+#include <algorithm>
+using namespace Ll;
+
+static const int s_regexLines = 10000;
+static const int s_listEntries = 100000;
+static const int s_maxQueries = 5000;
+static const int s_nodesPerStep = 500; // as in Project::onFillNodes
+
+namespace
+{
+    // Linear congruential generator; deterministic on all platforms, unlike qrand()
+    class Random
+    {
+    public:
+        explicit Random(quint32 seed):d_state(seed ? seed : 1) {}
+        int below( int n )
+        {
+            d_state = d_state * 1664525u + 1013904223u;
+            return n > 0 ? int( ( d_state >> 8 ) % quint32(n) ) : 0;
+        }
+    private:
+        quint32 d_state;
+    };
+
+    struct Pos
+    {
+        QString d_file;
+        int d_line, d_col;
+    };
+}
+
+static QString moduleName( int i )
+{
+    return QString("M%1").arg( i, 4, 10, QChar('0') );
+}
+
+static void writeModule( QTextStream& out, int i, const Benchmark::Corpus& c, Random& rnd )
+{
+    static const char* ops[] = { "+", "-", "&", "|", "^" };
+    const QString name = moduleName(i);
+    const int refs = qMin( c.d_refs, i ); // only modules with a lower number are instantiated
+    const int wires = qMax( 1, c.d_statements );
+
+    out << "(* generated module " << i << " *)\n";
+    out << "MODULE " << name << " (IN clk, rst: BIT; IN a, b: [8] BIT; OUT y: [8] BIT);\n";
+    if( refs > 0 )
+    {
+        out << "  VAR";
+        for( int r = 0; r < refs; r++ )
+            out << " u" << r << ": " << moduleName( rnd.below(i) ) << ";";
+        out << "\n";
+    }
+    out << "  REG (clk) r0, r1, r2: [8] BIT;\n";
+    for( int w = 0; w < wires; w += 10 )
+    {
+        out << "  WIRE";
+        for( int k = w; k < qMin( w + 10, wires ); k++ )
+            out << ( k > w ? ", w" : " w" ) << k;
+        out << ": [8] BIT;\n";
+    }
+    out << "BEGIN\n";
+    for( int r = 0; r < refs; r++ )
+        out << "  u" << r << "(clk, rst, a, r" << r % 3 << ");\n";
+    for( int w = 0; w < wires; w++ )
+    {
+        // operands are the inputs, registers, earlier wires and instance outputs
+        QStringList operands;
+        for( int k = 0; k < 2; k++ )
+        {
+            const int pick = rnd.below( 4 );
+            if( pick == 0 && w > 0 )
+                operands << QString("w%1").arg( rnd.below(w) );
+            else if( pick == 1 && refs > 0 )
+                operands << QString("u%1.y").arg( rnd.below(refs) );
+            else if( pick == 2 )
+                operands << QString("r%1").arg( rnd.below(3) );
+            else
+                operands << ( rnd.below(2) ? "a" : "b" );
+        }
+        out << "  w" << w << " := ";
+        if( rnd.below(4) == 0 )
+            out << "rst -> 0 : ";
+        out << operands[0] << " " << ops[ rnd.below(5) ] << " " << operands[1] << ";\n";
+    }
+    out << "  r0 := ~rst -> 0 : w" << wires - 1 << ";\n";
+    out << "  r1 := w" << wires / 2 << ";\n";
+    out << "  r2 := r1 ^ a;\n";
+    out << "  y := r0\n";
+    out << "END " << name << ".\n";
+}
+
+static bool writeFile( const QString& path, const QByteArray& text )
+{
+    QFile f(path);
+    if( !f.open(QIODevice::WriteOnly) )
+        return false;
+    return f.write(text) == text.size();
+}
+
+QString Benchmark::generate(const QString& dir, const Benchmark::Corpus& c)
+{
+    QDir base(dir);
+    if( !base.mkpath("src") )
+        return QString();
+    Random rnd( c.d_seed );
+    for( int i = 0; i < c.d_modules; i++ )
+    {
+        QByteArray text;
+        QTextStream out(&text);
+        writeModule( out, i, c, rnd );
+        out.flush();
+        if( !writeFile( base.absoluteFilePath( QString("src/%1.Lola").arg( moduleName(i) ) ), text ) )
+            return QString();
+    }
+
+    // $$replace and contains on every line, i.e. regular expressions
+    QByteArray regex;
+    regex += "NAMES = alpha beta gamma delta epsilon\n";
+    for( int i = 0; i < s_regexLines; i++ )
+    {
+        if( i % 2 )
+            regex += "contains(NAMES, \"g.*a\"): HIT" + QByteArray::number(i) + " = 1\n";
+        else
+            regex += "V" + QByteArray::number(i) + " = $$replace(NAMES, \"^(a|b)[a-z]+$\", x" +
+                    QByteArray::number(i) + ")\n";
+    }
+    // a generated file list as written by other tools
+    QByteArray list = "SRCFILES += \\\n";
+    for( int i = 0; i < s_listEntries; i++ )
+    {
+        list += " src/gen/f" + QByteArray::number(i) + ".Lola";
+        if( i % 10 == 9 && i + 1 < s_listEntries )
+            list += " \\\n";
+    }
+    list += "\n";
+    // the same as one assignment per line, at full and at a quarter of the size
+    QByteArray lines, quarter;
+    for( int i = 0; i < s_listEntries; i++ )
+    {
+        const QByteArray line = "SRCFILES += src/gen/f" + QByteArray::number(i) + ".Lola\n";
+        lines += line;
+        if( i < s_listEntries / 4 )
+            quarter += line;
+    }
+
+    const QString proFile = base.absoluteFilePath("bench.llpro");
+    if( !writeFile( base.absoluteFilePath("regex.llpro"), regex ) ||
+            !writeFile( base.absoluteFilePath("list.llpro"), list ) ||
+            !writeFile( base.absoluteFilePath("lines.llpro"), lines ) ||
+            !writeFile( base.absoluteFilePath("lines4.llpro"), quarter ) ||
+            !writeFile( proFile, "SRCDIRS += src\n" ) )
+        return QString();
+    return proFile;
+}
+
+typedef QList<double> Samples;
+
+template<class F>
+static Samples measure( int repeat, F body )
+{
+    Samples res;
+    QElapsedTimer t;
+    for( int i = 0; i < repeat; i++ )
+    {
+        t.start();
+        body();
+        res.append( t.nsecsElapsed() / 1000000.0 );
+    }
+    return res;
+}
+
+static double median( const Samples& sorted )
+{
+    const int n = sorted.size();
+    if( n == 0 )
+        return 0;
+    return n % 2 ? sorted[n/2] : ( sorted[n/2-1] + sorted[n/2] ) / 2.0;
+}
+
+// bytes is the size of the input for throughput benchmarks
+static QJsonObject report( const QString& name, const Samples& samples, int items, qint64 bytes = 0 )
+{
+    Samples sorted = samples;
+    std::sort( sorted.begin(), sorted.end() );
+    QJsonObject o;
+    o["name"] = name;
+    o["items"] = items;
+    o["iterations"] = sorted.size();
+    if( !sorted.isEmpty() )
+    {
+        const double med = median(sorted);
+        Samples dev;
+        foreach( double d, sorted )
+            dev.append( qAbs( d - med ) );
+        std::sort( dev.begin(), dev.end() );
+        o["min_ms"] = sorted.first();
+        o["median_ms"] = med;
+        o["mad_ms"] = median(dev);
+        o["max_ms"] = sorted.last();
+        if( bytes > 0 && med > 0 )
+            o["mb_per_s"] = bytes / ( med * 1000.0 );
+    }
+    QJsonArray a;
+    foreach( double d, samples )
+        a.append(d);
+    o["samples_ms"] = a;
+    return o;
+}
+
+static void indexFiles( CrossRefModel& mdl, const QStringList& files )
+{
+    // the model parses on its own thread and signals when parsing and resolving are done
+    bool done = false;
+    QEventLoop loop;
+    QMetaObject::Connection c = QObject::connect( &mdl, &CrossRefModel::sigModelUpdated, [&]() {
+        done = true;
+        loop.quit();
+    });
+    mdl.updateFiles( files );
+    if( !done && !files.isEmpty() )
+        loop.exec();
+    QObject::disconnect(c);
+}
+
+static QStringList readLines( const QString& path )
+{
+    QFile f(path);
+    if( !f.open(QIODevice::ReadOnly) )
+        return QStringList();
+    return QString::fromLatin1( f.readAll() ).split('\n');
+}
+
+QJsonObject Benchmark::run(const QString& dir, const Benchmark::Corpus& c, int repeat)
+{
+    QDir base(dir);
+    const QString proFile = base.absoluteFilePath("bench.llpro");
+    QJsonArray benchmarks;
+
+    ProjectLoader::Result project;
+    benchmarks.append( report( "ProjectFile.evaluate", measure( repeat, [&]() {
+        project = ProjectLoader::evaluate( proFile );
+    }), 1 ) );
+    benchmarks.append( report( "ProjectFile.evaluate.regex", measure( repeat, [&]() {
+        ProjectLoader::evaluate( base.absoluteFilePath("regex.llpro") );
+    }), s_regexLines ) );
+    // the same with a regex compiled per call, as before the cache
+    ProjectFile::setRegexCacheEnabled(false);
+    benchmarks.append( report( "ProjectFile.evaluate.regex.uncached", measure( repeat, [&]() {
+        ProjectLoader::evaluate( base.absoluteFilePath("regex.llpro") );
+    }), s_regexLines ) );
+    ProjectFile::setRegexCacheEnabled(true);
+    benchmarks.append( report( "ProjectFile.evaluate.list", measure( repeat, [&]() {
+        ProjectLoader::evaluate( base.absoluteFilePath("list.llpro") );
+    }), s_listEntries ) );
+    const QJsonObject quarter = report( "ProjectFile.evaluate.lines.quarter", measure( repeat, [&]() {
+        ProjectLoader::evaluate( base.absoluteFilePath("lines4.llpro") );
+    }), s_listEntries / 4 );
+    QJsonObject full = report( "ProjectFile.evaluate.lines", measure( repeat, [&]() {
+        ProjectLoader::evaluate( base.absoluteFilePath("lines.llpro") );
+    }), s_listEntries );
+    // cost per entry of the full list relative to the quarter; about 1 if linear, 4 if quadratic
+    const double perEntry = quarter.value("median_ms").toDouble() / quarter.value("items").toInt();
+    if( perEntry > 0 )
+        full["scaling"] = full.value("median_ms").toDouble() / full.value("items").toInt() / perEntry;
+    benchmarks.append( quarter );
+    benchmarks.append( full );
+    benchmarks.append( report( "ProjectLoader.discover", measure( repeat, [&]() {
+        DirScanner::clearCache();
+        ProjectLoader::discover( proFile, project );
+    }), 1 ) );
+    // what opening a project with the generated list costs before parsing: evaluation, discovery
+    // and the grouping Project::onFillNodes does per slice of the project tree
+    const QString listFile = base.absoluteFilePath("list.llpro");
+    ProjectLoader::Result listed;
+    benchmarks.append( report( "ProjectLoader.load.list", measure( repeat, [&]() {
+        listed = ProjectLoader::load( listFile );
+    }), s_listEntries ) );
+    benchmarks.append( report( "ProjectLoader.groupByFolder.list", measure( repeat, [&]() {
+        for( int i = 0; i < listed.d_srcFiles.size(); i += s_nodesPerStep )
+            ProjectLoader::groupByFolder( base, listed.d_srcFiles.mid( i, s_nodesPerStep ) );
+    }), s_listEntries ) );
+    const QStringList files = project.d_srcFiles;
+
+    // the lexer work Highlighter1::highlightBlock does, one call per line
+    QList<QStringList> texts;
+    int lines = 0;
+    qint64 bytes = 0; // the corpus is latin1, one byte per character
+    foreach( const QString& f, files )
+    {
+        texts.append( readLines(f) );
+        lines += texts.last().size();
+        foreach( const QString& line, texts.last() )
+            bytes += line.size();
+    }
+    QList<Pos> idents;
+    benchmarks.append( report( "Lexer.highlightLines", measure( repeat, [&]() {
+        const bool collect = idents.isEmpty();
+        for( int i = 0; i < texts.size(); i++ )
+        {
+            const QStringList& text = texts[i];
+            for( int l = 0; l < text.size(); l++ )
+            {
+                Lexer lex;
+                lex.setIgnoreComments(false);
+                lex.setPackComments(false);
+                const QList<Token> tokens = lex.tokens( text[l] );
+                if( !collect )
+                    continue;
+                foreach( const Token& t, tokens )
+                {
+                    if( t.d_type == Tok_identifier )
+                    {
+                        Pos p;
+                        p.d_file = files[i];
+                        p.d_line = l + 1;
+                        p.d_col = t.d_colNr;
+                        idents.append(p);
+                    }
+                }
+            }
+        }
+    }), lines, bytes ) );
+    auto spanLex = [&]() {
+        QVector<SpanLexer::Span> spans;
+        for( int i = 0; i < texts.size(); i++ )
+        {
+            const QStringList& text = texts[i];
+            for( int l = 0; l < text.size(); l++ )
+                SpanLexer::scan( text[l].constData(), text[l].size(), spans );
+        }
+    };
+    benchmarks.append( report( "SpanLexer.highlightLines", measure( repeat, spanLex ), lines, bytes ) );
+    // the same per scan kernel level up to the one of this CPU, scalar being the baseline
+    const ScanKernels::Level level = ScanKernels::level();
+    for( int l = ScanKernels::Scalar; l <= ScanKernels::supported(); l++ )
+    {
+        ScanKernels::setLevel( ScanKernels::Level(l) );
+        benchmarks.append( report( QString("SpanLexer.scan.%1").arg( ScanKernels::name( ScanKernels::Level(l) ) ),
+                                   measure( repeat, spanLex ), lines, bytes ) );
+    }
+    ScanKernels::setLevel( level );
+
+    FileCache fcache;
+    QScopedPointer<CrossRefModel> mdl;
+    benchmarks.append( report( "CrossRefModel.index", measure( repeat, [&]() {
+        mdl.reset();
+        mdl.reset( new CrossRefModel( 0, &fcache ) );
+        indexFiles( *mdl, files );
+    }), files.size() ) );
+
+    // evenly spread cursor positions as EditorWidget1::onCursor would see them
+    QList<Pos> queries;
+    const int step = qMax( 1, idents.size() / s_maxQueries );
+    for( int i = 0; i < idents.size(); i += step )
+        queries.append( idents[i] );
+
+    typedef QPair<CrossRefModel::IdentDeclRef,QString> DeclInFile;
+    QList<DeclInFile> decls;
+    benchmarks.append( report( "CrossRefModel.findSymbolBySourcePos", measure( repeat, [&]() {
+        const bool collect = decls.isEmpty();
+        foreach( const Pos& p, queries )
+        {
+            CrossRefModel::TreePath path = mdl->findSymbolBySourcePos( p.d_file, p.d_line, p.d_col );
+            if( !collect || path.isEmpty() )
+                continue;
+            CrossRefModel::IdentDeclRef id( path.first()->toIdentDecl() );
+            if( id.data() == 0 )
+                id = mdl->findDeclarationOfSymbol( path.first().data() );
+            if( id.data() != 0 )
+                decls.append( qMakePair( id, p.d_file ) );
+        }
+    }), queries.size() ) );
+    benchmarks.append( report( "CrossRefModel.findReferencingSymbolsByFile", measure( repeat, [&]() {
+        foreach( const DeclInFile& d, decls )
+            mdl->findReferencingSymbolsByFile( d.first.data(), d.second );
+    }), decls.size() ) );
+
+    // the model side of ModuleLocator/SymbolLocator::matchesFor
+    const QStringList patterns = QStringList() << "M" << "M00" << "m01" << "7" << "zz";
+    int matches = 0;
+    QJsonObject locator = report( "Locator.matchGlobalNames", measure( repeat, [&]() {
+        foreach( const QString& pattern, patterns )
+        {
+            CrossRefModel::IdentDeclRefList l = mdl->getGlobalNames();
+            QStringMatcher matcher( pattern, Qt::CaseInsensitive );
+            foreach( const CrossRefModel::IdentDeclRef& id, l )
+            {
+                if( matcher.indexIn( QString::fromLatin1( id->tok().d_val ) ) != -1 )
+                    matches++;
+            }
+        }
+    }), patterns.size() );
+    locator["matches"] = matches;
+    benchmarks.append( locator );
+    mdl.reset();
+
+    QJsonObject corpus;
+    corpus["modules"] = c.d_modules;
+    corpus["refs"] = c.d_refs;
+    corpus["statements"] = c.d_statements;
+    corpus["seed"] = double(c.d_seed);
+    corpus["files"] = files.size();
+    corpus["lines"] = lines;
+
+    QJsonObject res;
+    res["tool"] = QString("lolaindex");
+    res["format"] = 1;
+    res["qt"] = QString(qVersion());
+    res["repeat"] = repeat;
+    res["corpus"] = corpus;
+    res["benchmarks"] = benchmarks;
+    return res;
+}
+
+bool Benchmark::readCorpus(const QJsonObject& results, Benchmark::Corpus& c)
+{
+    const QJsonObject corpus = results.value("corpus").toObject();
+    if( !corpus.contains("modules") )
+        return false;
+    c.d_modules = corpus.value("modules").toInt( c.d_modules );
+    c.d_refs = corpus.value("refs").toInt( c.d_refs );
+    c.d_statements = corpus.value("statements").toInt( c.d_statements );
+    c.d_seed = quint32( corpus.value("seed").toDouble( c.d_seed ) );
+    return true;
+}
+
+int Benchmark::compare(const QJsonObject& baseline, const QJsonObject& current, double tolerance, QString& report)
+{
+    // MAD times 1.4826 estimates the standard deviation of normally distributed samples
+    static const double s_madScale = 1.4826;
+    static const double s_minDeltaMs = 0.05; // below the timer resolution of some platforms
+    static const double s_maxScaling = 2.0; // cost per item, large over small input; independent of the baseline
+
+    QHash<QString,QJsonObject> base;
+    foreach( const QJsonValue& v, baseline.value("benchmarks").toArray() )
+        base.insert( v.toObject().value("name").toString(), v.toObject() );
+
+    int regressions = 0;
+    foreach( const QJsonValue& v, current.value("benchmarks").toArray() )
+    {
+        const QJsonObject cur = v.toObject();
+        const QString name = cur.value("name").toString();
+        const double now = cur.value("median_ms").toDouble();
+        if( cur.contains("scaling") && cur.value("scaling").toDouble() > s_maxScaling )
+        {
+            report += QString("%1  cost per item grew %2 times with the input size  NOT LINEAR\n")
+                    .arg( name, -44 ).arg( cur.value("scaling").toDouble(), 0, 'f', 1 );
+            regressions++;
+        }
+        if( !base.contains(name) )
+        {
+            // an unchecked benchmark has to be recorded in the baseline first
+            report += QString("%1  %2 ms  MISSING IN BASELINE\n").arg( name, -44 ).arg( now, 10, 'f', 3 );
+            regressions++;
+            continue;
+        }
+        const QJsonObject b = base.value(name);
+        const double was = b.value("median_ms").toDouble();
+        const double noise = 3.0 * s_madScale * qMax( b.value("mad_ms").toDouble(), cur.value("mad_ms").toDouble() );
+        const double delta = now - was;
+        const bool regressed = delta > qMax( tolerance * was, qMax( noise, s_minDeltaMs ) );
+        if( regressed )
+            regressions++;
+        report += QString("%1  %2 ms  %3 ms  %4%  %5\n").arg( name, -44 )
+                .arg( was, 10, 'f', 3 ).arg( now, 10, 'f', 3 )
+                .arg( was > 0 ? 100.0 * delta / was : 0.0, 7, 'f', 1 )
+                .arg( regressed ? "REGRESSION" : "ok" );
+    }
+    return regressions;
+}
@@ -0,0 +1,66 @@
+#ifndef LLBENCHMARK_H
+#define LLBENCHMARK_H
+
+/*
+* Copyright 2019 Rochus Keller <mailto:me@rochus-keller.ch>
+*
+* This file is part of the LolaCreator plugin.
+*
+* The following is the license that applies to this copy of the
+* plugin. For a license to use the plugin under conditions
+* other than those described here, please email to me@rochus-keller.ch.
+*
+* GNU General Public License Usage
+* This file may be used under the terms of the GNU General Public
+* License (GPL) versions 2.0 or 3.0 as published by the Free Software
+* Foundation and appearing in the file LICENSE.GPL included in
+* the packaging of this file. Please review the following information
+* to ensure GNU General Public Licensing requirements will be met:
+* http://www.fsf.org/licensing/licenses/info/GPLv2.html and
+* http://www.gnu.org/copyleft/gpl.html.
+*/
+
+#include <QStringList>
+#include <QJsonObject>
+
+namespace Ll
+{
+    // Synthetic Lola-2 corpus and micro benchmarks of the indexing hot paths, used by lolaindex.
+    // The corpus only depends on the parameters and the seed, so results are comparable across
+    // machines and releases.
+    class Benchmark
+    {
+    public:
+        struct Corpus
+        {
+            int d_modules; // one module per file
+            int d_refs; // module instances per module, i.e. the reference density
+            int d_statements; // wire assignments per module, i.e. the file size
+            quint32 d_seed;
+            Corpus():d_modules(200),d_refs(3),d_statements(40),d_seed(1) {}
+        };
+
+        // Writes the Lola files, bench.llpro and the project files used by the ProjectFile
+        // benchmarks to dir; returns the path of bench.llpro or an empty string on error
+        static QString generate( const QString& dir, const Corpus& );
+
+        // Runs all benchmarks on a corpus generated by generate(); each one is repeated and the
+        // samples are reported in milliseconds
+        static QJsonObject run( const QString& dir, const Corpus&, int repeat );
+
+        // Reads the corpus parameters of earlier results; false if they have none
+        static bool readCorpus( const QJsonObject& results, Corpus& );
+
+        // A benchmark regresses if its median grew by more than tolerance (relative) and by more
+        // than the noise, i.e. three scaled median absolute deviations of the noisier run. Appends
+        // one line per benchmark to report and returns the number of regressions. Benchmarks
+        // missing in the baseline count as regressions; an empty baseline is skipped by the caller.
+        // Benchmarks which report a scaling also regress if their cost per item is not about linear.
+        static int compare( const QJsonObject& baseline, const QJsonObject& current, double tolerance,
+                            QString& report );
+    private:
+        Benchmark() {}
+    };
+}
+
+#endif // LLBENCHMARK_H
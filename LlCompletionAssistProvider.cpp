@@ -20,6 +20,7 @@
 #include "LlCompletionAssistProvider.h"
 #include "LolaCreatorConstants.h"
 #include "LlModelManager.h"
+#include "LlPerfMonitor.h"
 #include <texteditor/codeassist/iassistproposal.h>
 #include <texteditor/codeassist/assistinterface.h>
 #include <texteditor/codeassist/iassistprocessor.h>
@@ -54,6 +55,7 @@ namespace Ll
             const QString seq = QChar(' ') + ai->textDocument()->findBlock(curPos).text().left(colNr-1);
             //const QString seq = ai->textAt(curPos, -CompletionAssistProvider::SeqLen );
             const QString fileName = ai->fileName();
+            ScopedTimer timer( "CompletionAssistProcessor::perform", fileName );
 
             CrossRefModel* mdl = ModelManager::instance()->getModelForCurrentProject();
             if( mdl == 0 )
@@ -0,0 +1,166 @@
+/*
+* Copyright 2019 Rochus Keller <mailto:me@rochus-keller.ch>
+*
+* This file is part of the LolaCreator plugin.
+*
+* The following is the license that applies to this copy of the
+* plugin. For a license to use the plugin under conditions
+* other than those described here, please email to me@rochus-keller.ch.
+*
+* GNU General Public License Usage
+* This file may be used under the terms of the GNU General Public
+* License (GPL) versions 2.0 or 3.0 as published by the Free Software
+* Foundation and appearing in the file LICENSE.GPL included in
+* the packaging of this file. Please review the following information
+* to ensure GNU General Public Licensing requirements will be met:
+* http://www.fsf.org/licensing/licenses/info/GPLv2.html and
+* http://www.gnu.org/copyleft/gpl.html.
+*/
+
+#include "LlDirScanner.h"
+#include <QDirIterator>
+#include <QDateTime>
+#include <QMutex>
+#include <QCache>
+#include <QSet>
+#include <QtConcurrent/QtConcurrentMap>
+using namespace Ll;
+
+namespace
+{
+    struct Listing
+    {
+        QDateTime d_modified;
+        QDateTime d_read; // when the listing was read
+        QStringList d_files; // names
+        QStringList d_dirs; // names
+        QStringList d_canonDirs; // canonical paths of d_dirs
+    };
+
+    struct Item
+    {
+        QString d_path; // as seen by the user, i.e. possibly through symlinks
+        QString d_canon;
+        Item( const QString& p = QString(), const QString& c = QString() ):d_path(p),d_canon(c){}
+    };
+
+    QMutex s_lock;
+    QCache<QString,Listing> s_cache(10000); // canonical dir path -> listing, one cost unit per directory
+    // coarsest directory mtime resolution to expect (FAT); a listing read within this time of the
+    // last modification might miss a file created in the same tick
+    const qint64 s_mtimeResolutionMs = 2000;
+}
+
+static Listing readDir( const QString& canonPath )
+{
+    const QDateTime modified = QFileInfo(canonPath).lastModified();
+    {
+        QMutexLocker lock(&s_lock);
+        const Listing* l = s_cache.object(canonPath);
+        if( l != 0 && l->d_modified == modified && modified.msecsTo( l->d_read ) >= s_mtimeResolutionMs )
+            return *l;
+    }
+    Listing l;
+    l.d_modified = modified;
+    l.d_read = QDateTime::currentDateTime();
+    // one readdir pass for files and subdirectories
+    QDirIterator it( canonPath, QDir::Dirs | QDir::Files | QDir::NoDotAndDotDot );
+    while( it.hasNext() )
+    {
+        it.next();
+        const QFileInfo info = it.fileInfo();
+        if( info.isDir() )
+        {
+            l.d_dirs.append( info.fileName() );
+            l.d_canonDirs.append( info.canonicalFilePath() );
+        }else
+            l.d_files.append( info.fileName() );
+    }
+    QMutexLocker lock(&s_lock);
+    s_cache.insert( canonPath, new Listing(l) );
+    return l;
+}
+
+static inline QString join( const QString& dir, const QString& name )
+{
+    if( dir.endsWith('/') )
+        return dir + name;
+    else
+        return dir + QLatin1Char('/') + name;
+}
+
+static inline bool matches( const QString& name, const QStringList& suffixes )
+{
+    foreach( const QString& s, suffixes )
+    {
+        if( name.endsWith( s, Qt::CaseInsensitive ) )
+            return true;
+    }
+    return false;
+}
+
+void DirScanner::findFiles(const QDir& base, const QString& dirPath, const QStringList& suffixes,
+                           QStringList& out, bool recursive, QStringList* dirs)
+{
+    const QString root = QDir::cleanPath( base.absoluteFilePath(dirPath) );
+    const QString canon = QFileInfo(root).canonicalFilePath();
+    if( canon.isEmpty() )
+        return; // existiert nicht
+
+    QSet<QString> visited;
+    visited.insert(canon);
+    QList<Item> level;
+    level << Item(root,canon);
+    while( !level.isEmpty() )
+    {
+        QList<Listing> listings;
+        if( level.size() == 1 )
+            listings << readDir( level.first().d_canon );
+        else
+        {
+            QStringList paths;
+            foreach( const Item& i, level )
+                paths << i.d_canon;
+            listings = QtConcurrent::blockingMapped< QList<Listing> >( paths, readDir );
+        }
+        QList<Item> next;
+        for( int i = 0; i < level.size(); i++ )
+        {
+            const Listing& l = listings[i];
+            if( dirs )
+                dirs->append( level[i].d_path );
+            if( !suffixes.isEmpty() )
+            {
+                foreach( const QString& name, l.d_files )
+                {
+                    if( matches( name, suffixes ) )
+                        out.append( join( level[i].d_path, name ) );
+                }
+            }
+            if( !recursive )
+                continue;
+            for( int j = 0; j < l.d_dirs.size(); j++ )
+            {
+                // a symlink pointing to an ancestor or a dir seen before would loop or duplicate
+                if( l.d_canonDirs[j].isEmpty() || visited.contains( l.d_canonDirs[j] ) )
+                    continue;
+                visited.insert( l.d_canonDirs[j] );
+                next << Item( join( level[i].d_path, l.d_dirs[j] ), l.d_canonDirs[j] );
+            }
+        }
+        level = next;
+    }
+}
+
+void DirScanner::invalidate(const QStringList& dirs)
+{
+    QMutexLocker lock(&s_lock);
+    foreach( const QString& d, dirs )
+        s_cache.remove( QFileInfo(d).canonicalFilePath() );
+}
+
+void DirScanner::clearCache()
+{
+    QMutexLocker lock(&s_lock);
+    s_cache.clear();
+}
@@ -0,0 +1,48 @@
+#ifndef LLDIRSCANNER_H
+#define LLDIRSCANNER_H
+
+/*
+* Copyright 2019 Rochus Keller <mailto:me@rochus-keller.ch>
+*
+* This file is part of the LolaCreator plugin.
+*
+* The following is the license that applies to this copy of the
+* plugin. For a license to use the plugin under conditions
+* other than those described here, please email to me@rochus-keller.ch.
+*
+* GNU General Public License Usage
+* This file may be used under the terms of the GNU General Public
+* License (GPL) versions 2.0 or 3.0 as published by the Free Software
+* Foundation and appearing in the file LICENSE.GPL included in
+* the packaging of this file. Please review the following information
+* to ensure GNU General Public Licensing requirements will be met:
+* http://www.fsf.org/licensing/licenses/info/GPLv2.html and
+* http://www.gnu.org/copyleft/gpl.html.
+*/
+
+#include <QDir>
+#include <QStringList>
+
+namespace Ll
+{
+    // Discovers source files below directories; depends on QtCore only. Each directory is read
+    // in one pass, the levels of a recursive scan are read in parallel, and the listings are
+    // cached by directory modification time so that reloads only read changed directories. The
+    // cache holds a bounded number of directories.
+    class DirScanner
+    {
+    public:
+        // Appends the files below dirPath whose names end with one of the suffixes (case
+        // insensitive). A relative dirPath is resolved against base, never against the process
+        // CWD. Directories reached twice via symlinks are only scanned once. The visited
+        // directories are appended to dirs if not null.
+        static void findFiles( const QDir& base, const QString& dirPath, const QStringList& suffixes,
+                               QStringList& out, bool recursive, QStringList* dirs = 0 );
+        static void invalidate( const QStringList& dirs ); // e.g. when a watcher reports them
+        static void clearCache();
+    private:
+        DirScanner() {}
+    };
+}
+
+#endif // LLDIRSCANNER_H
@@ -23,10 +23,12 @@
 #include "LlIndenter.h"
 #include "LolaCreatorConstants.h"
 #include <QtDebug>
+#include <QFileInfo>
 #include <Lola/LlCrossRefModel.h>
 #include <coreplugin/idocument.h>
 #include <utils/fileutils.h>
 #include "LlModelManager.h"
+#include "LlPerfMonitor.h"
 #include "LlHighlighter.h"
 #include "LlAutoCompleter.h"
 #include "LlCompletionAssistProvider.h"
@@ -37,6 +39,8 @@ using namespace Ll;
 
 static const int s_processIntervalMs = 150;
 
+qint64 EditorDocument1::s_largeFileBytes = 8 * 1024 * 1024;
+
 Editor1::Editor1()
 {
     addContext(LolaCreator::Constants::LangLola);
@@ -47,7 +51,7 @@ Editor2::Editor2()
     addContext(LolaCreator::Constants::LangQmake);
 }
 
-EditorDocument1::EditorDocument1():d_opening(false)
+EditorDocument1::EditorDocument1():d_opening(false),d_large(false)
 {
     setId(LolaCreator::Constants::EditorId1);
 
@@ -55,17 +59,24 @@ EditorDocument1::EditorDocument1():d_opening(false)
     d_processorTimer.setSingleShot(true);
     d_processorTimer.setInterval(s_processIntervalMs);
     connect(&d_processorTimer, SIGNAL(timeout()), this, SLOT(onProcess()));
-
+    connect( this, SIGNAL(filePathChanged(Utils::FileName,Utils::FileName)),
+             this, SLOT(onFilePathChanged(Utils::FileName,Utils::FileName)) );
 }
 
 EditorDocument1::~EditorDocument1()
 {
     ModelManager::instance()->getFileCache()->removeFile( filePath().toString() );
+    if( !filePath().isEmpty() )
+        ModelManager::instance()->release( filePath().toFileInfo().path() );
 }
 
 TextEditor::TextDocument::OpenResult EditorDocument1::open(QString* errorString, const QString& fileName, const QString& realFileName)
 {
     d_opening = true;
+    // decided before the text is set, since that highlights all blocks
+    d_large = s_largeFileBytes > 0 && QFileInfo(realFileName).size() >= s_largeFileBytes;
+    if( Highlighter1* hl = dynamic_cast<Highlighter1*>( syntaxHighlighter() ) )
+        hl->setLazy( d_large );
     const TextDocument::OpenResult res = TextDocument::open(errorString, fileName, realFileName );
     // wird nach EditorWidget::finalizeInitialization aufgerufen!
     d_opening = false;
@@ -76,15 +87,32 @@ bool EditorDocument1::save(QString* errorString, const QString& fileName, bool a
 {
     const bool res = TextDocument::save(errorString,fileName, autoSave);
     if( !autoSave )
+    {
         ModelManager::instance()->getFileCache()->removeFile( filePath().toString() );
+        if( d_large && res )
+        {
+            // large files are only analysed on save, and from disk instead of a snapshot
+            emit sigStartProcessing();
+            const QString file = filePath().toString();
+            CrossRefModel* mdl = ModelManager::instance()->getModelForCurrentProject();
+            if( mdl == 0 )
+                mdl = ModelManager::instance()->getModelForDir(file);
+            ModelManager::instance()->updateFiles( mdl, QStringList() << file );
+        }
+    }
     return res;
 }
 
+void EditorDocument1::setLargeFileThreshold(qint64 bytes)
+{
+    s_largeFileBytes = qMax( qint64(0), bytes );
+}
+
 void EditorDocument1::onChangedContents()
 {
     if( d_opening )
         emit sigLoaded();
-    else
+    else if( !d_large )
         d_processorTimer.start(s_processIntervalMs);
 }
 
@@ -92,11 +120,22 @@ void EditorDocument1::onProcess()
 {
     emit sigStartProcessing();
     const QString file = filePath().toString();
-    ModelManager::instance()->getFileCache()->addFile( file, plainText().toLatin1() );
+    ScopedTimer timer( "EditorDocument1::onProcess", file );
+    const QByteArray text = plainText().toLatin1();
+    ModelManager::instance()->getFileCache()->addFile( file, text );
     CrossRefModel* mdl = ModelManager::instance()->getModelForCurrentProject();
     if( mdl == 0 )
         mdl = ModelManager::instance()->getModelForDir(file);
-    mdl->updateFiles( QStringList() << file );
+    ModelManager::instance()->updateFiles( mdl, QStringList() << file );
+}
+
+void EditorDocument1::onFilePathChanged(const Utils::FileName& oldName, const Utils::FileName& newName)
+{
+    // the document keeps the model of its directory alive until it is closed
+    if( !newName.isEmpty() )
+        ModelManager::instance()->addRef( newName.toFileInfo().path() );
+    if( !oldName.isEmpty() )
+        ModelManager::instance()->release( oldName.toFileInfo().path() );
 }
 
 EditorDocument2::EditorDocument2()
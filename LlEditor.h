@@ -54,6 +54,11 @@ namespace Ll
         TextDocument::OpenResult open(QString *errorString, const QString &fileName, const QString &realFileName);
         bool save(QString *errorString, const QString &fileName, bool autoSave);
 
+        // Files of at least this size open in large file mode: lazy highlighting, analysis on
+        // save instead of while typing; 0 switches the mode off
+        static void setLargeFileThreshold( qint64 bytes );
+        bool isLargeFile() const { return d_large; }
+
     signals:
         void sigLoaded();
         void sigStartProcessing();
@@ -61,9 +66,12 @@ namespace Ll
     protected slots:
         void onChangedContents();
         void onProcess();
+        void onFilePathChanged(const Utils::FileName& oldName, const Utils::FileName& newName);
     private:
         QTimer d_processorTimer;
+        static qint64 s_largeFileBytes;
         bool d_opening;
+        bool d_large;
     };
 
     class EditorDocument2 : public TextEditor::TextDocument
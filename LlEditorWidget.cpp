@@ -22,6 +22,11 @@
 #include "LlEditor.h"
 #include "LlModelManager.h"
 #include "LlOutlineMdl.h"
+#include "LlSemanticHighlighter.h"
+#include "LlWorkScheduler.h"
+#include "LlHighlighter.h"
+#include "LlPerfMonitor.h"
+#include "LlTraceRecorder.h"
 #include <Lola/LlCrossRefModel.h>
 #include <Lola/LlErrors.h>
 #include <Lola/LlSynTree.h>
@@ -32,6 +37,7 @@
 #include <texteditor/textdocumentlayout.h>
 #include <texteditor/texteditorconstants.h>
 #include <texteditor/fontsettings.h>
+#include <texteditor/displaysettings.h>
 #include <coreplugin/find/searchresultwindow.h>
 #include <coreplugin/actionmanager/actionmanager.h>
 #include <coreplugin/actionmanager/command.h>
@@ -41,14 +47,21 @@
 #include <QTime>
 #include <QTextBlock>
 #include <QMenu>
+#include <QLabel>
+#include <QScrollBar>
+#include <QtConcurrentRun>
 using namespace Ll;
 
 // TODO const Core::IDocument *currentDocument = Core::EditorManager::currentDocument();
 
 typedef QList<QTextEdit::ExtraSelection> ExtraSelections;
 
-EditorWidget1::EditorWidget1():d_outline(0)
+static const int s_maxLargeFileDiagnostics = 500;
+static const int s_largeFileIndexDelayMs = 500;
+
+EditorWidget1::EditorWidget1():d_outline(0),d_semantic(0),d_scheduler(0),d_largeFile(0),d_indexPending(false)
 {
+    connect( &d_indexWatcher, SIGNAL(finished()), this, SLOT(onIndexBuilt()) );
 }
 
 EditorWidget1::~EditorWidget1()
@@ -62,6 +75,9 @@ void EditorWidget1::finalizeInitialization()
 
     connect( textDocument(), SIGNAL(filePathChanged(Utils::FileName,Utils::FileName)), this, SLOT(onDocReady()) );
     connect( this, SIGNAL(cursorPositionChanged()), this, SLOT(onCursor()) );
+    // brackets and BEGIN/IF/MODULE ... END are matched along the parsed MatchTable instead
+    setParenthesesMatchingEnabled(false);
+    connect( this, SIGNAL(cursorPositionChanged()), this, SLOT(onMatchParentheses()) );
     connect( qobject_cast<EditorDocument1*>(textDocument()), SIGNAL(sigStartProcessing()),
              this, SLOT(onStartProcessing()) );
 
@@ -85,6 +101,11 @@ void EditorWidget1::finalizeInitialization()
 
     insertExtraToolBarWidget(TextEditorWidget::Left, d_outline );
 
+    // diagnostics, occurrences and semantic colours are applied to the visible blocks first
+    d_scheduler = new WorkScheduler(this);
+    d_semantic = new SemanticHighlighter( textDocument() );
+    connect( d_semantic, SIGNAL(sigReady()), this, SLOT(onSemanticReady()) );
+
 }
 
 static bool lessThan1(const CrossRefModel::SymRef &s1, const CrossRefModel::SymRef &s2)
@@ -143,6 +164,12 @@ void EditorWidget1::onFindUsages()
 
 void EditorWidget1::onGotoOuterBlock()
 {
+    if( isIndexFresh() )
+    {
+        gotoPosition( d_index.outerBlock( textCursor().position() ) );
+        return;
+    }
+    // the index is outdated until the pending parse is done
     QTextCursor cur = textCursor();
     const QString file = textDocument()->filePath().toString();
     CrossRefModel* mdl = ModelManager::instance()->getModelForCurrentProjectOrDirPath(file);
@@ -175,12 +202,236 @@ void EditorWidget1::onFileUpdated(const QString& path)
     const QString file = textDocument()->filePath().toString();
     if( file == path )
     {
+        TraceRecorder::instant( "EditorWidget1::onFileUpdated", file );
         onUpdateCodeWarnings();
+        updateIndex();
+        if( d_semantic )
+            d_semantic->update( ModelManager::instance()->getModelForCurrentProjectOrDirPath(file) );
+    }
+}
+
+void EditorWidget1::updateIndex()
+{
+    // built along with each parse, so the index is fresh whenever the model is; in large file
+    // mode also shortly after each edit
+    if( d_indexWatcher.isRunning() )
+    {
+        d_indexPending = true;
+        return;
+    }
+    d_indexPending = false;
+    d_indexWatcher.setFuture( QtConcurrent::run( &StructureIndex::build, textDocument()->plainText(),
+                                                 document()->revision() ) );
+}
+
+void EditorWidget1::onIndexBuilt()
+{
+    if( d_indexPending )
+        updateIndex();
+    else
+    {
+        d_index = d_indexWatcher.result();
+        if( Highlighter1* hl = dynamic_cast<Highlighter1*>( textDocument()->syntaxHighlighter() ) )
+            hl->setMatches( d_index.matches() );
+        onMatchParentheses();
+    }
+}
+
+bool EditorWidget1::isIndexFresh() const
+{
+    return d_index.revision() == document()->revision();
+}
+
+void EditorWidget1::gotoPosition(int pos)
+{
+    if( pos < 0 )
+        return;
+    Core::EditorManager::cutForwardNavigationHistory();
+    Core::EditorManager::addCurrentPositionToNavigationHistory();
+    QTextCursor cur = textCursor();
+    cur.setPosition( pos );
+    setTextCursor( cur );
+}
+
+void EditorWidget1::onGotoNextModule()
+{
+    if( isIndexFresh() )
+        gotoPosition( d_index.nextModule( textCursor().position() ) );
+}
+
+void EditorWidget1::onGotoPreviousModule()
+{
+    if( isIndexFresh() )
+        gotoPosition( d_index.previousModule( textCursor().position() ) );
+}
+
+void EditorWidget1::onGotoNextDeclaration()
+{
+    if( isIndexFresh() )
+        gotoPosition( d_index.nextDeclaration( textCursor().position() ) );
+}
+
+void EditorWidget1::onGotoPreviousDeclaration()
+{
+    if( isIndexFresh() )
+        gotoPosition( d_index.previousDeclaration( textCursor().position() ) );
+}
+
+void EditorWidget1::onSelectEnclosingStatement()
+{
+    int start, end;
+    if( !isIndexFresh() || !d_index.enclosingStatement( textCursor().position(), start, end ) )
+        return;
+    QTextCursor cur = textCursor();
+    cur.setPosition( start );
+    cur.setPosition( end, QTextCursor::KeepAnchor );
+    setTextCursor( cur );
+}
+
+bool EditorWidget1::findMatch(int& pos, int& partner) const
+{
+    // the cursor may be on or right behind a bracket, or anywhere in a keyword
+    const QTextCursor cur = textCursor();
+    QTextCursor word = cur;
+    word.movePosition( QTextCursor::StartOfWord );
+    const int candidates[] = { cur.position(), cur.position() - 1, word.position() };
+    const MatchTable& matches = d_index.matches();
+    for( int i = 0; i < 3; i++ )
+    {
+        if( matches.contains( candidates[i] ) )
+        {
+            pos = candidates[i];
+            partner = matches.match( pos );
+            return true;
+        }
     }
+    return false;
+}
+
+int EditorWidget1::tokenLength(int pos) const
+{
+    // keywords are highlighted as a whole, brackets are one character
+    int end = pos;
+    while( document()->characterAt(end).isLetter() )
+        end++;
+    return qMax( 1, end - pos );
+}
+
+void EditorWidget1::onGotoMatching()
+{
+    QTextCursor cur = textCursor();
+    if( isIndexFresh() )
+    {
+        int pos, partner;
+        if( findMatch( pos, partner ) )
+            gotoPosition( partner );
+        return;
+    }
+    // the table is outdated until the pending parse is done; fall back to the lexical parentheses
+    if( TextEditor::TextBlockUserData::matchCursorForward( &cur ) == TextEditor::TextBlockUserData::Match ||
+            TextEditor::TextBlockUserData::matchCursorBackward( &cur ) == TextEditor::TextBlockUserData::Match )
+    {
+        Core::EditorManager::addCurrentPositionToNavigationHistory();
+        cur.clearSelection();
+        setTextCursor( cur );
+    }
+}
+
+void EditorWidget1::onGotoBlockEnd()
+{
+    // the END of the innermost block around the cursor; if the cursor is already there, the next outer one
+    const int cur = textCursor().position();
+    if( !isIndexFresh() )
+    {
+        // the index is outdated until the pending parse is done; the lexical BEGIN, IF and END meanwhile
+        int depth = 0;
+        for( QTextBlock block = textCursor().block(); block.isValid(); block = block.next() )
+        {
+            foreach( const TextEditor::Parenthesis& p, TextEditor::TextDocumentLayout::parentheses(block) )
+            {
+                if( !p.chr.isLetter() )
+                    continue; // brackets
+                const int pos = block.position() + p.pos;
+                if( p.type == TextEditor::Parenthesis::Opened )
+                {
+                    if( pos >= cur )
+                        depth++;
+                }else if( pos - 2 > cur ) // an END is registered at its last character
+                {
+                    if( depth == 0 )
+                    {
+                        gotoPosition( pos - 2 );
+                        return;
+                    }
+                    depth--;
+                }
+            }
+        }
+        return;
+    }
+    int pos = cur;
+    int start;
+    while( ( start = d_index.outerBlock( pos ) ) != -1 )
+    {
+        const int end = d_index.matches().match( start );
+        if( end > cur )
+        {
+            gotoPosition( end );
+            return;
+        }
+        pos = start;
+    }
+}
+
+void EditorWidget1::onMatchParentheses()
+{
+    ExtraSelections sels;
+    if( displaySettings().m_highlightMatchingParentheses )
+    {
+        const QTextCharFormat f = textDocument()->fontSettings().toTextCharFormat( TextEditor::C_PARENTHESES );
+        auto add = [&]( int pos, int len )
+        {
+            QTextEdit::ExtraSelection sel;
+            sel.format = f;
+            sel.cursor = textCursor();
+            sel.cursor.setPosition( pos );
+            sel.cursor.setPosition( pos + len, QTextCursor::KeepAnchor );
+            sels.append( sel );
+        };
+        if( isIndexFresh() )
+        {
+            int pos, partner;
+            if( findMatch( pos, partner ) && partner != -1 )
+            {
+                add( pos, tokenLength(pos) );
+                add( partner, tokenLength(partner) );
+            }
+        }else
+        {
+            // the table is outdated until the pending parse is done; the lexical parentheses meanwhile
+            QTextCursor backward = textCursor();
+            QTextCursor forward = textCursor();
+            if( TextEditor::TextBlockUserData::matchCursorBackward( &backward ) == TextEditor::TextBlockUserData::Match )
+            {
+                add( backward.selectionStart(), 1 );
+                add( backward.selectionEnd() - 1, 1 );
+            }
+            if( TextEditor::TextBlockUserData::matchCursorForward( &forward ) == TextEditor::TextBlockUserData::Match )
+            {
+                add( forward.selectionStart(), 1 );
+                add( forward.selectionEnd() - 1, 1 );
+            }
+        }
+    }
+    setExtraSelections( TextEditor::TextEditorWidget::ParenthesesMatchingSelection, sels );
 }
 
 void EditorWidget1::onStartProcessing()
 {
+    // what is still pending refers to the text before the edit
+    d_scheduler->cancel( DiagnosticsJob );
+    d_scheduler->cancel( SemanticJob );
+    d_scheduler->cancel( OccurrencesJob );
     setExtraSelections( TextEditor::TextEditorWidget::CodeSemanticsSelection, ExtraSelections() );
     setExtraSelections( TextEditor::TextEditorWidget::CodeWarningsSelection, ExtraSelections() );
 }
@@ -190,14 +441,41 @@ static bool lessThan2(const QTextEdit::ExtraSelection &s1, const QTextEdit::Extr
     return s1.cursor.position() < s2.cursor.position();
 }
 
+static bool lessThan3(const Errors::Entry& e1, const Errors::Entry& e2)
+{
+    return e1.d_line < e2.d_line;
+}
+
 void EditorWidget1::onUpdateCodeWarnings()
 {
     const QString file = textDocument()->filePath().toString();
+    ScopedTimer timer( "EditorWidget1::onUpdateCodeWarnings", file );
     CrossRefModel* mdl = ModelManager::instance()->getModelForCurrentProjectOrDirPath(file);
     Q_ASSERT( mdl != 0 );
-    QTextDocument* doc = textDocument()->document();
 
-    Errors::EntryList errs = mdl->getErrs()->getErrors(file);
+    d_errs = mdl->getErrs()->getErrors(file);
+    std::stable_sort(d_errs.begin(), d_errs.end(), lessThan3);
+    if( d_largeFile )
+    {
+        if( d_errs.size() > s_maxLargeFileDiagnostics )
+        {
+            d_largeFile->setText( tr("Large file: first %1 of %2 diagnostics").arg(s_maxLargeFileDiagnostics)
+                                  .arg(d_errs.size()) );
+            d_errs = d_errs.mid( 0, s_maxLargeFileDiagnostics );
+        }else
+            d_largeFile->setText( tr("Large file") );
+    }
+    d_warnings.clear();
+    d_scheduler->schedule( DiagnosticsJob, [this]( int from, int to ) { addCodeWarnings( from, to ); },
+                           [this]() {
+        std::sort(d_warnings.begin(), d_warnings.end(), lessThan2);
+        setExtraSelections( TextEditor::TextEditorWidget::CodeWarningsSelection, d_warnings );
+    });
+}
+
+void EditorWidget1::addCodeWarnings(int from, int to)
+{
+    QTextDocument* doc = textDocument()->document();
 
     QTextCharFormat errorFormat;
     errorFormat.setUnderlineStyle(QTextCharFormat::WaveUnderline);
@@ -207,10 +485,12 @@ void EditorWidget1::onUpdateCodeWarnings()
     warningFormat.setUnderlineStyle(QTextCharFormat::WaveUnderline);
     warningFormat.setUnderlineColor(Qt::darkYellow);
 
-    ExtraSelections result;
-
-    foreach (const Errors::Entry& e, errs)
+    Errors::Entry first;
+    first.d_line = from + 1;
+    for( Errors::EntryList::const_iterator i = std::lower_bound( d_errs.begin(), d_errs.end(), first, lessThan3 );
+         i != d_errs.end() && int((*i).d_line) <= to; ++i )
     {
+        const Errors::Entry& e = *i;
         QTextCursor c( doc->findBlockByNumber(e.d_line - 1) );
 
         c.setPosition( c.position() + e.d_col - 1 );
@@ -238,12 +518,37 @@ void EditorWidget1::onUpdateCodeWarnings()
 
         sel.format.setToolTip(QString("%1: %2").arg(what).arg(e.d_msg));
 
-        result.append(sel);
+        d_warnings.append(sel);
     }
+}
 
-    std::sort(result.begin(), result.end(), lessThan2);
+void EditorWidget1::addOccurrences(int from, int to)
+{
+    QTextDocument* doc = textDocument()->document();
+    const QTextCharFormat format = textDocument()->fontSettings().toTextCharFormat(TextEditor::C_OCCURRENCES);
 
-    setExtraSelections( TextEditor::TextEditorWidget::CodeWarningsSelection, result );
+    CrossRefModel::SymRefList::const_iterator i = std::lower_bound( d_uses.constBegin(), d_uses.constEnd(), from + 1,
+                    []( const CrossRefModel::SymRef& s, int line ) { return int(s->tok().d_lineNr) < line; } );
+    for( ; i != d_uses.constEnd() && int((*i)->tok().d_lineNr) <= to; ++i )
+    {
+        const CrossRefModel::SymRef& use = *i;
+        const int line = use->tok().d_lineNr - 1;
+        const int position = doc->findBlockByNumber(line).position() + use->tok().d_colNr - 1;
+        const int anchor = position + use->tok().d_len;
+
+        QTextEdit::ExtraSelection sel;
+        sel.format = format;
+        sel.cursor = QTextCursor(doc);
+        sel.cursor.setPosition(anchor);
+        sel.cursor.setPosition(position, QTextCursor::KeepAnchor);
+
+        d_occurrences.append(sel);
+    }
+}
+
+void EditorWidget1::onSemanticReady()
+{
+    d_scheduler->schedule( SemanticJob, [this]( int from, int to ) { d_semantic->apply( from, to ); } );
 }
 
 TextEditor::TextEditorWidget::Link EditorWidget1::findLinkAt(const QTextCursor& cur, bool resolveTarget, bool inNextSplit)
@@ -301,36 +606,11 @@ void EditorWidget1::contextMenuEvent(QContextMenuEvent* e)
     delete menu;
 }
 
-static ExtraSelections toExtraSelections(const CrossRefModel::SymRefList& uses,
-                                                           TextEditor::TextStyle style, TextEditor::TextDocument* document )
-{
-    ExtraSelections result;
-
-    QTextDocument* doc = document->document();
-
-    foreach (const CrossRefModel::SymRef& use, uses)
-    {
-        const int position = doc->findBlockByNumber(use->tok().d_lineNr - 1).position() +
-                use->tok().d_colNr - 1;
-        const int anchor = position + use->tok().d_len;
-
-        QTextEdit::ExtraSelection sel; //
-        sel.format = document->fontSettings().toTextCharFormat(style);
-        sel.cursor = QTextCursor(doc);
-        sel.cursor.setPosition(anchor);
-        sel.cursor.setPosition(position, QTextCursor::KeepAnchor);
-
-        result.append(sel);
-    }
-
-    std::sort(result.begin(), result.end(), lessThan2);
-    return result;
-}
-
 void EditorWidget1::onCursor()
 {
     QTextCursor cur = textCursor();
     const QString file = textDocument()->filePath().toString();
+    ScopedTimer timer( "EditorWidget1::onCursor", file );
     CrossRefModel* mdl = ModelManager::instance()->getModelForCurrentProjectOrDirPath(file);
     if( mdl == 0 )
         return;
@@ -354,11 +634,19 @@ void EditorWidget1::onCursor()
             // qDebug() << "******* hit on" << id->tok().d_val;
 //            foreach( const CrossRefModel::SymRef& ref, res )
 //                qDebug() << QFileInfo(ref->tok().d_sourcePath).fileName() << ref->tok().d_lineNr << ref->tok().d_colNr;
-            setExtraSelections(TextEditor::TextEditorWidget::CodeSemanticsSelection,
-                               toExtraSelections(res, TextEditor::C_OCCURRENCES, textDocument() ) );
-
+            std::sort(res.begin(), res.end(), lessThan1 );
+            d_uses = res;
+            d_occurrences.clear();
+            d_scheduler->schedule( OccurrencesJob, [this]( int from, int to ) { addOccurrences( from, to ); },
+                                   [this]() {
+                std::sort(d_occurrences.begin(), d_occurrences.end(), lessThan2);
+                setExtraSelections( TextEditor::TextEditorWidget::CodeSemanticsSelection, d_occurrences );
+            });
         }else
+        {
+            d_scheduler->cancel( OccurrencesJob );
             setExtraSelections(TextEditor::TextEditorWidget::CodeSemanticsSelection, ExtraSelections() );
+        }
     }
 
 //    path = mdl->findSymbolBySourcePos( file, line, col, false, true );
@@ -402,15 +690,61 @@ void EditorWidget1::onDocReady()
     Q_ASSERT(mdl != 0 );
     connect( mdl, SIGNAL(sigFileUpdated(QString)), this, SLOT(onFileUpdated(QString)) );
 
+    EditorDocument1* doc = qobject_cast<EditorDocument1*>( textDocument() );
+    if( doc && doc->isLargeFile() && d_largeFile == 0 )
+        enterLargeFileMode();
+
     OutlineMdl1* outline = static_cast<OutlineMdl1*>( d_outline->model() );
     outline->setFile(fileName);
 
     if( !mdl->isEmpty() )
     {
         onUpdateCodeWarnings();
+        updateIndex();
+        d_semantic->update( mdl );
     }
 }
 
+void EditorWidget1::enterLargeFileMode()
+{
+    d_largeFile = new QLabel( tr("Large file"), this );
+    d_largeFile->setToolTip( tr("This file is larger than the large file threshold. It is only highlighted where "
+                                "you look, analysed when saved, and shows a limited number of diagnostics.") );
+    insertExtraToolBarWidget( TextEditorWidget::Right, d_largeFile );
+
+    static_cast<OutlineMdl1*>( d_outline->model() )->setLazy(true);
+    d_outline->installEventFilter(this);
+
+    connect( verticalScrollBar(), SIGNAL(valueChanged(int)), this, SLOT(onHighlightVisible()) );
+    // queued, so that the highlighter has forgotten the chunks which moved before
+    connect( document(), SIGNAL(blockCountChanged(int)), this, SLOT(onHighlightVisible()), Qt::QueuedConnection );
+    onHighlightVisible();
+
+    // the file is only parsed when saved, but navigation works on the lexed index meanwhile
+    d_indexTimer.setSingleShot(true);
+    d_indexTimer.setInterval(s_largeFileIndexDelayMs);
+    connect( &d_indexTimer, SIGNAL(timeout()), this, SLOT(updateIndex()) );
+    connect( document(), SIGNAL(contentsChanged()), &d_indexTimer, SLOT(start()) );
+}
+
+void EditorWidget1::onHighlightVisible()
+{
+    Highlighter1* hl = dynamic_cast<Highlighter1*>( textDocument()->syntaxHighlighter() );
+    if( hl == 0 || !hl->isLazy() )
+        return;
+    int from, to;
+    d_scheduler->visibleRange( from, to );
+    hl->highlightRange( from, to );
+}
+
+bool EditorWidget1::eventFilter(QObject* obj, QEvent* e)
+{
+    // the lazy outline is filled when the user is about to look at it
+    if( obj == d_outline && ( e->type() == QEvent::MouseButtonPress || e->type() == QEvent::KeyPress ) )
+        static_cast<OutlineMdl1*>( d_outline->model() )->refresh();
+    return TextEditorWidget::eventFilter( obj, e );
+}
+
 void EditorWidget1::gotoSymbolInEditor()
 {
     OutlineMdl1* mdl = static_cast<OutlineMdl1*>( d_outline->model() );
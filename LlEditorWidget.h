@@ -22,13 +22,20 @@
 
 #include <texteditor/texteditor.h>
 #include <utils/treeviewcombobox.h>
+#include <Lola/LlCrossRefModel.h>
+#include <Lola/LlErrors.h>
+#include <QFutureWatcher>
+#include <QTimer>
+#include "LlStructureIndex.h"
 
 namespace Core { class SearchResultItem; }
+class QLabel;
 
 namespace Ll
 {
     class EditorDocument1;
-    class CrossRefModel;
+    class SemanticHighlighter;
+    class WorkScheduler;
 
     class EditorWidget1 : public TextEditor::TextEditorWidget
     {
@@ -45,6 +52,13 @@ namespace Ll
     public slots:
         void onFindUsages();
         void onGotoOuterBlock();
+        void onGotoMatching();
+        void onGotoBlockEnd();
+        void onGotoNextModule();
+        void onGotoPreviousModule();
+        void onGotoNextDeclaration();
+        void onGotoPreviousDeclaration();
+        void onSelectEnclosingStatement();
         void onFileUpdated( const QString& );
         void onStartProcessing();
 
@@ -52,16 +66,43 @@ namespace Ll
         Link findLinkAt(const QTextCursor &, bool resolveTarget = true,
                         bool inNextSplit = false) Q_DECL_OVERRIDE;
         void contextMenuEvent(QContextMenuEvent *e) Q_DECL_OVERRIDE;
+        bool eventFilter(QObject *, QEvent *) Q_DECL_OVERRIDE;
 
     protected slots:
         void onUpdateCodeWarnings();
+        void onHighlightVisible();
         void onCursor();
         void onOpenEditor(const Core::SearchResultItem &item);
         void onDocReady();
         void gotoSymbolInEditor();
         void updateToolTip();
+        void onSemanticReady();
+        void onIndexBuilt();
+        void updateIndex();
+        void onMatchParentheses();
+    protected:
+        // the parts of the per-document work in the blocks from..to, see WorkScheduler
+        void addCodeWarnings( int from, int to );
+        void addOccurrences( int from, int to );
+        void enterLargeFileMode();
+        bool isIndexFresh() const;
+        void gotoPosition( int pos );
+        bool findMatch( int& pos, int& partner ) const; // along the MatchTable, which must be fresh
+        int tokenLength( int pos ) const;
     private:
+        enum { DiagnosticsJob, SemanticJob, OccurrencesJob };
         Utils::TreeViewComboBox* d_outline;
+        SemanticHighlighter* d_semantic;
+        WorkScheduler* d_scheduler;
+        Errors::EntryList d_errs; // ordered by line
+        CrossRefModel::SymRefList d_uses; // ordered by position
+        QList<QTextEdit::ExtraSelection> d_warnings;
+        QList<QTextEdit::ExtraSelection> d_occurrences;
+        QLabel* d_largeFile; // only in large file mode
+        StructureIndex d_index; // fresh if its revision is the one of the document
+        QFutureWatcher<StructureIndex> d_indexWatcher;
+        QTimer d_indexTimer; // large file mode only, where edits are not parsed
+        bool d_indexPending;
     };
 
     class EditorWidget2 : public TextEditor::TextEditorWidget
@@ -18,15 +18,25 @@
 */
 
 #include "LlHighlighter.h"
-#include "LlModelManager.h"
+#include "LlPerfMonitor.h"
+#include "LlSpanLexer.h"
+#include "LlScanKernels.h"
 #include <texteditor/textdocumentlayout.h>
 #include <QBuffer>
+#include <QTextDocument>
 using namespace Ll;
 using namespace TextEditor;
 
+static const int s_lazyChunk = 100;
+static const int s_foldingDelayMs = 100;
+
 Highlighter1::Highlighter1(QTextDocument* parent) :
-    SyntaxHighlighter(parent)
+    SyntaxHighlighter(parent),d_blockCount(0),d_foldFrom(0),d_foldTo(0),d_foldRevision(-1),d_lazy(false)
 {
+    d_foldingTimer.setSingleShot(true);
+    d_foldingTimer.setInterval(s_foldingDelayMs);
+    QObject::connect( &d_foldingTimer, &QTimer::timeout, [this]() { updateFolding(); } );
+
     for( int i = 0; i < C_Max; i++ )
     {
         d_format[i].setFontWeight(QFont::Normal);
@@ -55,20 +65,94 @@ QTextCharFormat Highlighter1::formatForCategory(int c) const
     return d_format[c];
 }
 
+void Highlighter1::setLazy(bool on)
+{
+    d_lazy = on;
+    d_highlighted.clear();
+    QObject::disconnect( d_contentsChange );
+    if( on && document() )
+    {
+        d_blockCount = document()->blockCount();
+        d_contentsChange = QObject::connect( document(), &QTextDocument::contentsChange,
+                                             [this]( int pos, int, int ) { onContentsChange(pos); } );
+    }
+}
+
+void Highlighter1::onContentsChange(int pos)
+{
+    // Inserted or removed lines move the blocks behind them to other chunks, so the chunks from
+    // the change on may hold blocks which only had their comment state scanned
+    const int blocks = document()->blockCount();
+    if( blocks == d_blockCount )
+        return;
+    d_blockCount = blocks;
+    const int chunk = document()->findBlock(pos).blockNumber() / s_lazyChunk;
+    if( chunk >= 0 && chunk < d_highlighted.size() )
+        d_highlighted.fill( false, chunk, d_highlighted.size() );
+}
+
+void Highlighter1::highlightRange(int from, int to)
+{
+    if( !d_lazy || document() == 0 )
+        return;
+    const int chunks = ( document()->blockCount() + s_lazyChunk - 1 ) / s_lazyChunk;
+    if( d_highlighted.size() < chunks )
+        d_highlighted.resize( chunks );
+    for( int c = qMax( 0, from / s_lazyChunk ); c < qMin( ( to + s_lazyChunk - 1 ) / s_lazyChunk, chunks ); c++ )
+    {
+        if( d_highlighted.testBit(c) )
+            continue;
+        d_highlighted.setBit(c);
+        // the comment state does not change, so each block is formatted on its own
+        QTextBlock block = document()->findBlockByNumber( c * s_lazyChunk );
+        for( int i = 0; i < s_lazyChunk && block.isValid(); i++, block = block.next() )
+            rehighlightBlock( block );
+    }
+}
+
+void Highlighter1::scanComments(const QString& text)
+{
+    int lexerState = qMax( previousBlockState(), 0 ) & 0xff;
+    const ushort* str = text.utf16();
+    int pos = 0;
+    while( pos < text.size() )
+    {
+        pos = lexerState == 1 ? ScanKernels::findCommentEnd( str, pos, text.size() ) :
+                                ScanKernels::findCommentStart( str, pos, text.size() );
+        if( pos == -1 )
+            break;
+        pos += 2;
+        lexerState = lexerState == 1 ? 0 : 1;
+    }
+    TextDocumentLayout::clearParentheses(currentBlock());
+    setCurrentBlockState( lexerState );
+}
+
 void Highlighter1::highlightBlock(const QString& text)
 {
+    ScopedTimer timer( "Highlighter1::highlightBlock" );
+    if( d_lazy )
+    {
+        const int chunk = currentBlock().blockNumber() / s_lazyChunk;
+        if( chunk >= d_highlighted.size() || !d_highlighted.testBit(chunk) )
+        {
+            scanComments(text);
+            return;
+        }
+    }
+    // The block state only holds the comment state, so that typing BEGIN or END does not change
+    // the state of all following blocks. Depths are relative to the start of the block here, and
+    // the folding indents are summed up by updateFolding later.
     const int previousBlockState_ = previousBlockState();
-    int lexerState = 0, initialBraceDepth = 0;
-    if (previousBlockState_ != -1) {
+    int lexerState = 0;
+    if (previousBlockState_ != -1)
         lexerState = previousBlockState_ & 0xff;
-        initialBraceDepth = previousBlockState_ >> 8;
-    }
 
+    const int initialBraceDepth = 0;
     int braceDepth = initialBraceDepth;
     int foldingIndent = initialBraceDepth;
 
     if (TextBlockUserData *userData = TextDocumentLayout::testUserData(currentBlock())) {
-        userData->setFoldingIndent(0);
         userData->setFoldingStartIncluded(false);
         userData->setFoldingEndIncluded(false);
     }
@@ -80,14 +164,14 @@ void Highlighter1::highlightBlock(const QString& text)
         // suche das Ende
         QTextCharFormat f = formatForCategory(C_Cmt);
         f.setProperty( TokenProp, int(Tok_Comment) );
-        int pos = text.indexOf("*)");
+        int pos = ScanKernels::findCommentEnd( text.utf16(), 0, text.size() );
         if( pos == -1 )
         {
             // the whole block ist part of the comment
             setFormat( start, text.size(), f );
             TextDocumentLayout::clearParentheses(currentBlock());
-            TextDocumentLayout::setFoldingIndent(currentBlock(), foldingIndent);
-            setCurrentBlockState( (braceDepth << 8) | lexerState);
+            setNesting( braceDepth, foldingIndent );
+            setCurrentBlockState( lexerState );
             return;
         }else
         {
@@ -103,16 +187,11 @@ void Highlighter1::highlightBlock(const QString& text)
     Parentheses parentheses;
     parentheses.reserve(20);
 
-    Lexer lex;
-    lex.setIgnoreComments(false);
-    lex.setPackComments(false);
-    if( ModelManager::instance()->getLastUsed() )
-        lex.setCache( ModelManager::instance()->getLastUsed()->getFcache() );
-
-    const QList<Token> tokens =  lex.tokens(text.mid(start));
-    for( int i = 0; i < tokens.size(); ++i )
+    // spans go to a buffer reused for all blocks, so there is no allocation per block
+    const int count = SpanLexer::scan( text.constData() + start, text.size() - start, d_spans, start );
+    for( int i = 0; i < count; ++i )
     {
-        const Token &t = tokens.at(i);
+        const SpanLexer::Span &t = d_spans[i];
 
         QTextCharFormat f;
         if( t.d_type == Tok_Comment )
@@ -137,13 +216,13 @@ void Highlighter1::highlightBlock(const QString& text)
             case Tok_Lbrack:
             case Tok_Lbrace:
             //case Tok_Latt:
-                parentheses.append(Parenthesis(Parenthesis::Opened, text[t.d_colNr-1], t.d_colNr-1 ));
+                parentheses.append(Parenthesis(Parenthesis::Opened, text[t.d_col], t.d_col ));
                 break;
             case Tok_Rpar:
             case Tok_Rbrack:
             case Tok_Rbrace:
             //case Tok_Ratt:
-                parentheses.append(Parenthesis(Parenthesis::Closed, text[t.d_colNr-1], t.d_colNr-1 ));
+                parentheses.append(Parenthesis(Parenthesis::Closed, text[t.d_col], t.d_col ));
                 break;
             }
             f = formatForCategory(C_Op);
@@ -151,7 +230,7 @@ void Highlighter1::highlightBlock(const QString& text)
         {
             if( t.d_type == Tok_BEGIN )
             {
-                parentheses.append(Parenthesis(Parenthesis::Opened, text[t.d_colNr-1], t.d_colNr-1 ));
+                parentheses.append(Parenthesis(Parenthesis::Opened, text[t.d_col], t.d_col ));
                 ++braceDepth;
                 // if a folding block opens at the beginning of a line, treat the entire line
                 // as if it were inside the folding block
@@ -160,14 +239,18 @@ void Highlighter1::highlightBlock(const QString& text)
                     ++foldingIndent;
                     TextDocumentLayout::userData(currentBlock())->setFoldingStartIncluded(true);
                 }
+            }else if( t.d_type == Tok_IF )
+            {
+                // closed by END like BEGIN, but not counted for the nesting
+                parentheses.append(Parenthesis(Parenthesis::Opened, text[t.d_col], t.d_col ));
             }else if( t.d_type == Tok_END )
             {
-                const int pos = t.d_colNr-1 + ::strlen(tokenTypeString(t.d_type))-1;
+                const int pos = t.d_col + t.d_len - 1;
                 parentheses.append(Parenthesis(Parenthesis::Closed, text[pos], pos ));
                 --braceDepth;
                 if (braceDepth < foldingIndent) {
                     // unless we are at the end of the block, we reduce the folding indent
-                    if (i == tokens.size()-1 || tokens.at(i+1).d_type == Tok_Semi )
+                    if (i == count-1 || d_spans[i+1].d_type == Tok_Semi )
                         TextDocumentLayout::userData(currentBlock())->setFoldingEndIncluded(true);
                     else
                         foldingIndent = qMin(braceDepth, foldingIndent);
@@ -183,7 +266,7 @@ void Highlighter1::highlightBlock(const QString& text)
         if( f.isValid() )
         {
             f.setProperty( TokenProp, int(t.d_type) );
-            setFormat( t.d_colNr-1, t.d_len, f );
+            setFormat( t.d_col, t.d_len, f );
         }
     }
 
@@ -196,8 +279,157 @@ void Highlighter1::highlightBlock(const QString& text)
         foldingIndent = initialBraceDepth;
     }
 
-    TextDocumentLayout::setFoldingIndent(currentBlock(), foldingIndent);
-    setCurrentBlockState((braceDepth << 8) | lexerState );
+    setNesting( braceDepth, foldingIndent );
+    setCurrentBlockState( lexerState );
+}
+
+namespace Ll
+{
+    // Nesting of a block relative to its start, kept in the user data of the block
+    class NestingData : public CodeFormatterData
+    {
+    public:
+        NestingData():d_delta(0),d_indent(0),d_depth(-1){}
+        int d_delta; // depth at the end of the block
+        int d_indent; // folding indent
+        int d_depth; // absolute depth at the start of the block as of the last updateFolding
+    };
+}
+
+static int depthAfter( const QTextBlock& block )
+{
+    // -1 if unknown
+    const TextBlockUserData* data = block.isValid() ? TextDocumentLayout::testUserData(block) : 0;
+    const NestingData* n = data ? static_cast<const NestingData*>( data->codeFormatterData() ) : 0;
+    if( n == 0 || n->d_depth < 0 )
+        return -1;
+    return qMax( 0, n->d_depth + n->d_delta );
+}
+
+void Highlighter1::setNesting(int delta, int indent)
+{
+    TextBlockUserData* data = TextDocumentLayout::userData(currentBlock());
+    NestingData* n = static_cast<NestingData*>( data->codeFormatterData() );
+    if( n == 0 )
+    {
+        n = new NestingData();
+        data->setCodeFormatterData(n);
+    }else if( n->d_delta == delta && n->d_indent == indent )
+    {
+        // unchanged, unless lines with a nesting were removed in front of this block
+        const QTextBlock prev = currentBlock().previous();
+        if( !prev.isValid() || n->d_depth == depthAfter(prev) )
+            return;
+    }
+    n->d_delta = delta;
+    n->d_indent = indent;
+    n->d_depth = -1;
+    const int nr = currentBlock().blockNumber();
+    if( !d_foldingTimer.isActive() )
+        d_foldFrom = d_foldTo = nr;
+    d_foldFrom = qMin( d_foldFrom, nr );
+    d_foldTo = qMax( d_foldTo, nr );
+    d_foldingTimer.start();
+}
+
+void Highlighter1::setMatches(const MatchTable& m)
+{
+    d_matches = m;
+    d_foldRevision = -1;
+    if( document() && d_matches.revision() == document()->revision() )
+    {
+        d_foldingTimer.stop();
+        updateFolding();
+    }
+}
+
+void Highlighter1::updateFolding()
+{
+    QTextDocument* doc = document();
+    if( doc == 0 )
+        return;
+    bool changed;
+    if( d_matches.revision() == doc->revision() )
+    {
+        // highlighting more blocks of a lazy document changes nothing then
+        if( d_foldRevision == doc->revision() )
+            return;
+        ScopedTimer timer( "Highlighter1::updateFolding" );
+        changed = foldAlongMatches();
+        d_foldRevision = doc->revision();
+    }else
+    {
+        ScopedTimer timer( "Highlighter1::updateFolding" );
+        changed = foldAlongNesting();
+    }
+    if( changed )
+    {
+        if( TextDocumentLayout* layout = qobject_cast<TextDocumentLayout*>( doc->documentLayout() ) )
+            layout->requestUpdate();
+    }
+}
+
+bool Highlighter1::foldAlongMatches()
+{
+    // a range folds the blocks after its opening keyword up to and including the one of its END
+    QTextDocument* doc = document();
+    QVector<int> delta( doc->blockCount() + 1, 0 );
+    QHash<int,int>::const_iterator i;
+    for( i = d_matches.pairs().begin(); i != d_matches.pairs().end(); ++i )
+    {
+        if( i.key() >= i.value() || !doc->characterAt( i.key() ).isLetter() )
+            continue; // closing direction or brackets
+        const int open = doc->findBlock( i.key() ).blockNumber();
+        const int close = doc->findBlock( i.value() ).blockNumber();
+        if( open < 0 || close <= open )
+            continue;
+        delta[open + 1]++;
+        delta[close + 1]--;
+    }
+    bool changed = false;
+    int indent = 0;
+    for( QTextBlock block = doc->begin(); block.isValid(); block = block.next() )
+    {
+        indent += delta[block.blockNumber()];
+        TextBlockUserData* data = TextDocumentLayout::userData(block);
+        if( data->foldingIndent() != indent )
+        {
+            data->setFoldingIndent( indent );
+            changed = true;
+        }
+    }
+    return changed;
+}
+
+bool Highlighter1::foldAlongNesting()
+{
+    // until the table is fresh again after an edit
+    QTextDocument* doc = document();
+    QTextBlock block = doc->findBlockByNumber( d_foldFrom );
+    int depth = qMax( 0, depthAfter( block.previous() ) );
+    bool changed = false;
+    for( ; block.isValid(); block = block.next() )
+    {
+        TextBlockUserData* data = TextDocumentLayout::userData(block);
+        NestingData* n = static_cast<NestingData*>( data->codeFormatterData() );
+        if( n == 0 )
+        {
+            n = new NestingData();
+            data->setCodeFormatterData(n);
+        }
+        // beyond the edited blocks nothing changes once the depth is the one of the last run
+        if( n->d_depth == depth && block.blockNumber() > d_foldTo )
+            break;
+        n->d_depth = depth;
+        const int indent = qMax( 0, depth + n->d_indent );
+        if( data->foldingIndent() != indent )
+        {
+            data->setFoldingIndent( indent );
+            changed = true;
+        }
+        depth = qMax( 0, depth + n->d_delta );
+    }
+    return changed;
 }
 
 
@@ -205,52 +437,65 @@ void Highlighter1::highlightBlock(const QString& text)
 static std::pair<int, TextEditor::TextStyle> make(int i,TextEditor::TextStyle s){
     return std::pair<int, TextEditor::TextStyle>(i,s);}
 
-Highlighter2::Highlighter2(const Keywords& keywords):m_keywords(keywords)
+Highlighter2::Highlighter2(const Keywords& keywords)
 {
+    // hashed once, so that each word of a block costs one lookup
+    const QStringList variables = keywords.variables();
+    const QStringList functions = keywords.functions();
+#if QT_VERSION >= QT_VERSION_CHECK(5, 14, 0)
+    m_variables = QSet<QString>(variables.begin(), variables.end());
+    m_functions = QSet<QString>(functions.begin(), functions.end());
+#else
+    m_variables = variables.toSet();
+    m_functions = functions.toSet();
+#endif
     static QVector<TextStyle> categories;
     categories << C_TYPE << C_KEYWORD << C_COMMENT << C_VISUAL_WHITESPACE;
     setTextFormatCategories(categories);
 }
 
+static inline bool isWordChar(const QChar& c)
+{
+    return c.isLetter() || c.isDigit() || c == QLatin1Char('_') || c == QLatin1Char('.');
+}
+
 void Highlighter2::highlightBlock(const QString& text)
 {
     if (text.isEmpty())
         return;
 
-    QString buf;
-    bool inCommentMode = false;
-
-    QTextCharFormat emptyFormat;
+    const QChar* str = text.constData();
+    const int len = text.size();
     int i = 0;
-    for (;;) {
-        const QChar c = text.at(i);
-        if (inCommentMode) {
-            setFormat(i, 1, formatForCategory(ProfileCommentFormat));
-        } else {
-            if (c.isLetter() || c == QLatin1Char('_') || c == QLatin1Char('.') || c.isDigit()) {
-                buf += c;
-                setFormat(i - buf.length()+1, buf.length(), emptyFormat);
-                if (!buf.isEmpty() && m_keywords.isFunction(buf))
-                    setFormat(i - buf.length()+1, buf.length(), formatForCategory(ProfileFunctionFormat));
-                else if (!buf.isEmpty() && m_keywords.isVariable(buf))
-                    setFormat(i - buf.length()+1, buf.length(), formatForCategory(ProfileVariableFormat));
-            } else if (c == QLatin1Char('(')) {
-                if (!buf.isEmpty() && m_keywords.isFunction(buf))
-                    setFormat(i - buf.length(), buf.length(), formatForCategory(ProfileFunctionFormat));
-                buf.clear();
-            } else if (c == QLatin1Char('#')) {
-                inCommentMode = true;
-                setFormat(i, 1, formatForCategory(ProfileCommentFormat));
-                buf.clear();
-            } else {
-                if (!buf.isEmpty() && m_keywords.isVariable(buf))
-                    setFormat(i - buf.length(), buf.length(), formatForCategory(ProfileVariableFormat));
-                buf.clear();
-            }
-        }
-        i++;
-        if (i >= text.length())
+    while (i < len) {
+        if (str[i] == QLatin1Char('#')) {
+            // the rest of the line is a comment
+            setFormat(i, len - i, formatForCategory(ProfileCommentFormat));
             break;
+        }
+        if (!isWordChar(str[i])) {
+            i++;
+            continue;
+        }
+        const int start = i;
+        while (i < len && isWordChar(str[i]))
+            i++;
+        // refers to the block text without copying it
+        const QString word = QString::fromRawData(str + start, i - start);
+        const bool isFunction = m_functions.contains(word);
+        const bool isVariable = m_variables.contains(word);
+        if (isFunction && isVariable) {
+            // e.g. CONFIG, a function only when called
+            int next = i;
+            while (next < len && str[next].isSpace())
+                next++;
+            const bool call = next < len && str[next] == QLatin1Char('(');
+            setFormat(start, i - start, formatForCategory(call ? ProfileFunctionFormat : ProfileVariableFormat));
+        } else if (isFunction) {
+            setFormat(start, i - start, formatForCategory(ProfileFunctionFormat));
+        } else if (isVariable) {
+            setFormat(start, i - start, formatForCategory(ProfileVariableFormat));
+        }
     }
 
     applyFormatToSpaces(text, formatForCategory(ProfileVisualWhitespaceFormat));
@@ -24,6 +24,11 @@
 #include <texteditor/syntaxhighlighter.h>
 #include <texteditor/codeassist/keywordscompletionassist.h>
 #include <Lola/LlLexer.h>
+#include "LlSpanLexer.h"
+#include "LlMatchTable.h"
+#include <QBitArray>
+#include <QSet>
+#include <QTimer>
 
 namespace Ll
 {
@@ -33,6 +38,15 @@ namespace Ll
         enum { TokenProp = QTextFormat::UserProperty };
         explicit Highlighter1(QTextDocument *parent = 0);
 
+        // Large files: blocks only get their comment state until highlightRange was called for them
+        void setLazy( bool );
+        bool isLazy() const { return d_lazy; }
+        void highlightRange( int from, int to ); // block numbers, to is exclusive
+
+        // The folding follows the BEGIN, IF and MODULE ... END of the table while it is fresh,
+        // otherwise the lexical BEGIN ... END nesting of the blocks
+        void setMatches( const MatchTable& );
+
     protected:
         QTextCharFormat formatForCategory(int) const;
 
@@ -41,7 +55,22 @@ namespace Ll
 
     private:
         enum Category { C_Num, C_Str, C_Kw, C_Type, C_Ident, C_Op, C_Pp, C_Cmt, C_Section, C_Brack, C_Max };
+        void scanComments( const QString &text ); // the cheap path of lazy mode
+        void onContentsChange( int pos );
+        void setNesting( int delta, int indent );
+        void updateFolding();
+        bool foldAlongMatches();
+        bool foldAlongNesting();
         QTextCharFormat d_format[C_Max];
+        QVector<SpanLexer::Span> d_spans;
+        QBitArray d_highlighted; // lazy mode, per chunk of blocks
+        QMetaObject::Connection d_contentsChange;
+        int d_blockCount; // lazy mode, as of the last contentsChange
+        QTimer d_foldingTimer;
+        MatchTable d_matches;
+        int d_foldRevision; // the document revision folded along d_matches, or -1
+        int d_foldFrom, d_foldTo; // blocks with changed nesting since the last updateFolding
+        bool d_lazy;
     };
 
     class Highlighter2 : public TextEditor::SyntaxHighlighter
@@ -59,7 +88,8 @@ namespace Ll
         void highlightBlock(const QString &text);
 
     private:
-        const TextEditor::Keywords m_keywords;
+        QSet<QString> m_variables;
+        QSet<QString> m_functions;
     };
 }
 
@@ -24,6 +24,7 @@
 #include <projectexplorer/project.h>
 #include "LlModelManager.h"
 #include "LlEditor.h"
+#include "LlPerfMonitor.h"
 #include <Lola/LlCrossRefModel.h>
 #include <utils/fileutils.h>
 #include <QTextBlock>
@@ -56,6 +57,7 @@ void HoverHandler::identifyMatch(TextEditor::TextEditorWidget* editorWidget, int
     cur.setPosition(pos);
 
     const QString file = editorWidget->textDocument()->filePath().toString();
+    ScopedTimer timer( "HoverHandler::identifyMatch", file );
     CrossRefModel* mdl = ModelManager::instance()->getModelForCurrentProjectOrDirPath(file);
 
     const int line = cur.blockNumber() + 1;
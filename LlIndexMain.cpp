@@ -0,0 +1,283 @@
+/*
+* Copyright 2019 Rochus Keller <mailto:me@rochus-keller.ch>
+*
+* This file is part of the LolaCreator plugin.
+*
+* The following is the license that applies to this copy of the
+* plugin. For a license to use the plugin under conditions
+* other than those described here, please email to me@rochus-keller.ch.
+*
+* GNU General Public License Usage
+* This file may be used under the terms of the GNU General Public
+* License (GPL) versions 2.0 or 3.0 as published by the Free Software
+* Foundation and appearing in the file LICENSE.GPL included in
+* the packaging of this file. Please review the following information
+* to ensure GNU General Public Licensing requirements will be met:
+* http://www.fsf.org/licensing/licenses/info/GPLv2.html and
+* http://www.gnu.org/copyleft/gpl.html.
+*/
+
+#include "LlProjectLoader.h"
+#include "LlProjectFile.h"
+#include "LlBenchmark.h"
+#include <Lola/LlCrossRefModel.h>
+#include <Lola/LlFileCache.h>
+#include <Lola/LlErrors.h>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFileInfo>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonArray>
+#include <QTemporaryDir>
+#include <stdio.h>
+using namespace Ll;
+
+static void usage()
+{
+    fprintf( stderr, "usage: lolaindex [-q] project.llpro\n"
+             "       lolaindex --generate DIR [corpus options]\n"
+             "       lolaindex --bench [--corpus DIR] [--repeat N] [--json FILE] [corpus options]\n"
+             "       lolaindex --bench --check BASELINE [--tolerance PCT] [--update-baseline]\n"
+             "  -q               only print errors, no warnings\n"
+             "  --generate DIR   write a synthetic Lola-2 corpus and bench.llpro to DIR\n"
+             "  --bench          run the benchmarks and print the results as JSON\n"
+             "  --corpus DIR     generate the benchmark corpus in DIR instead of a temporary directory\n"
+             "  --repeat N       samples per benchmark (default 5)\n"
+             "  --json FILE      write the results to FILE instead of stdout\n"
+             "  --check FILE     compare with the baseline FILE, using its corpus; exit code 1 on regressions\n"
+             "  --tolerance PCT  slowdown of the median tolerated beyond the noise (default 10)\n"
+             "  --update-baseline  write the results to the --check FILE instead of comparing\n"
+             "corpus options: --modules N (200) --refs N (3) --statements N (40) --seed N (1)\n" );
+}
+
+static int printEntries( const Errors::EntriesByFile& entries, const char* what )
+{
+    int count = 0;
+    for( Errors::EntriesByFile::const_iterator j = entries.begin(); j != entries.end(); ++j )
+    {
+        foreach( const Errors::Entry& e, j.value() )
+        {
+            fprintf( stdout, "%s:%d:%d: %s: %s\n", j.key().toLocal8Bit().constData(), int(e.d_line),
+                     int(e.d_col), what, e.d_msg.toLocal8Bit().constData() );
+            count++;
+        }
+    }
+    return count;
+}
+
+static int index( const QString& proFile, bool quiet )
+{
+    QElapsedTimer total;
+    total.start();
+    QElapsedTimer t;
+
+    t.start();
+    ProjectLoader::Result res = ProjectLoader::evaluate( proFile );
+    const qint64 evalMs = t.elapsed();
+    if( !res.d_ok )
+    {
+        fprintf( stderr, "%s: cannot evaluate project file\n", proFile.toLocal8Bit().constData() );
+        return 1;
+    }
+
+    t.restart();
+    ProjectLoader::discover( proFile, res );
+    const qint64 discoverMs = t.elapsed();
+
+    FileCache fcache;
+    CrossRefModel mdl( 0, &fcache );
+    QStringList defs = res.d_config.value("DEFINES");
+    defs.sort();
+    for( int i = 0; i < defs.size(); i++ )
+        defs[i] = "`define " + defs[i];
+    if( !mdl.parseString( defs.join('\n'), proFile ) )
+    {
+        fprintf( stderr, "%s: invalid DEFINES\n", proFile.toLocal8Bit().constData() );
+        return 1;
+    }
+
+    // the model parses on its own thread; the last sigFileUpdated ends the parse phase and
+    // sigModelUpdated the resolve phase
+    const QStringList files = res.d_srcFiles + res.d_libFiles;
+    int parsed = 0;
+    qint64 parseMs = 0;
+    bool done = false;
+    QEventLoop loop;
+    t.restart();
+    QObject::connect( &mdl, &CrossRefModel::sigFileUpdated, [&]() {
+        if( ++parsed == files.size() )
+            parseMs = t.elapsed();
+    });
+    QObject::connect( &mdl, &CrossRefModel::sigModelUpdated, [&]() {
+        done = true;
+        loop.quit();
+    });
+    mdl.updateFiles( files );
+    if( !done && !files.isEmpty() )
+        loop.exec();
+    const qint64 indexMs = t.elapsed();
+    if( parsed < files.size() )
+        parseMs = indexMs;
+
+    const int errs = printEntries( mdl.getErrs()->getErrors(), "error" );
+    int wrns = 0;
+    if( !quiet )
+        wrns = printEntries( mdl.getErrs()->getWarnings(), "warning" );
+
+    int hits = 0, misses = 0;
+    ProjectFile::includeCacheStatistics( hits, misses );
+    fprintf( stderr, "%d source files, %d library files, %d errors, %d warnings\n",
+             res.d_srcFiles.size(), res.d_libFiles.size(), errs, wrns );
+    fprintf( stderr, "evaluate %lld ms (include cache %d hits, %d misses)\n", evalMs, hits, misses );
+    fprintf( stderr, "discover %lld ms\n", discoverMs );
+    fprintf( stderr, "parse    %lld ms\n", parseMs );
+    fprintf( stderr, "resolve  %lld ms\n", indexMs - parseMs );
+    fprintf( stderr, "total    %lld ms\n", qint64(total.elapsed()) );
+    return errs > 0 ? 1 : 0;
+}
+
+static bool writeJson( const QString& path, const QJsonObject& obj )
+{
+    const QByteArray json = QJsonDocument( obj ).toJson();
+    if( path.isEmpty() )
+        return fwrite( json.constData(), 1, json.size(), stdout ) == size_t(json.size());
+    QFile out(path);
+    return out.open(QIODevice::WriteOnly) && out.write(json) == json.size();
+}
+
+static int bench( const QString& dir, Benchmark::Corpus corpus, int repeat, const QString& jsonFile,
+                  const QString& baselineFile, double tolerance, bool update )
+{
+    QJsonObject baseline;
+    if( !baselineFile.isEmpty() )
+    {
+        QFile in(baselineFile);
+        if( in.open(QIODevice::ReadOnly) )
+            baseline = QJsonDocument::fromJson( in.readAll() ).object();
+        else if( !update )
+        {
+            fprintf( stderr, "cannot read %s\n", baselineFile.toLocal8Bit().constData() );
+            return 1;
+        }
+        // there is nothing to check against until a baseline is recorded on the reference machine
+        if( !update && baseline.value("benchmarks").toArray().isEmpty() )
+        {
+            fprintf( stderr, "warning: %s has no benchmarks, check skipped; record it with --update-baseline\n",
+                     baselineFile.toLocal8Bit().constData() );
+            return 0;
+        }
+        // the baseline is only meaningful for the corpus it was recorded with
+        Benchmark::readCorpus( baseline, corpus );
+        if( baseline.contains("repeat") )
+            repeat = baseline.value("repeat").toInt( repeat );
+    }
+
+    QTemporaryDir tmp;
+    const QString path = dir.isEmpty() ? tmp.path() : dir;
+    if( Benchmark::generate( path, corpus ).isEmpty() )
+    {
+        fprintf( stderr, "cannot write the corpus to %s\n", path.toLocal8Bit().constData() );
+        return 1;
+    }
+    const QJsonObject results = Benchmark::run( path, corpus, repeat );
+    const QString outFile = update ? baselineFile : jsonFile;
+    if( ( !outFile.isEmpty() || baselineFile.isEmpty() ) && !writeJson( outFile, results ) )
+    {
+        fprintf( stderr, "cannot write %s\n", outFile.toLocal8Bit().constData() );
+        return 1;
+    }
+    if( baselineFile.isEmpty() || update )
+        return 0;
+
+    QString report;
+    const int regressions = Benchmark::compare( baseline, results, tolerance / 100.0, report );
+    fprintf( stdout, "%-44s  %13s  %13s  %8s\n%s", "benchmark", "baseline", "current", "delta",
+             report.toLocal8Bit().constData() );
+    if( regressions > 0 )
+    {
+        fprintf( stdout, "%d benchmark(s) failed the check\n", regressions );
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    app.setApplicationName("lolaindex");
+
+    QString proFile, generateDir, corpusDir, jsonFile, baselineFile;
+    bool quiet = false, benchMode = false, update = false;
+    int repeat = 5;
+    double tolerance = 10;
+    Benchmark::Corpus corpus;
+    const QStringList args = app.arguments();
+    for( int i = 1; i < args.size(); i++ )
+    {
+        const QString& a = args[i];
+        const bool hasValue = i + 1 < args.size();
+        bool ok = true;
+        if( a == "-q" )
+            quiet = true;
+        else if( a == "--bench" )
+            benchMode = true;
+        else if( a == "--generate" && hasValue )
+            generateDir = args[++i];
+        else if( a == "--corpus" && hasValue )
+            corpusDir = args[++i];
+        else if( a == "--json" && hasValue )
+            jsonFile = args[++i];
+        else if( a == "--check" && hasValue )
+            baselineFile = args[++i];
+        else if( a == "--tolerance" && hasValue )
+            tolerance = args[++i].toDouble(&ok);
+        else if( a == "--update-baseline" )
+            update = true;
+        else if( a == "--repeat" && hasValue )
+            repeat = args[++i].toInt(&ok);
+        else if( a == "--modules" && hasValue )
+            corpus.d_modules = args[++i].toInt(&ok);
+        else if( a == "--refs" && hasValue )
+            corpus.d_refs = args[++i].toInt(&ok);
+        else if( a == "--statements" && hasValue )
+            corpus.d_statements = args[++i].toInt(&ok);
+        else if( a == "--seed" && hasValue )
+            corpus.d_seed = args[++i].toUInt(&ok);
+        else if( a.startsWith('-') || !proFile.isEmpty() )
+            ok = false;
+        else
+            proFile = QFileInfo(a).absoluteFilePath();
+        if( !ok || repeat < 1 || tolerance < 0 )
+        {
+            usage();
+            return 2;
+        }
+    }
+
+    if( !generateDir.isEmpty() )
+    {
+        const QString res = Benchmark::generate( generateDir, corpus );
+        if( res.isEmpty() )
+        {
+            fprintf( stderr, "cannot write the corpus to %s\n", generateDir.toLocal8Bit().constData() );
+            return 1;
+        }
+        fprintf( stdout, "%s\n", res.toLocal8Bit().constData() );
+        return 0;
+    }
+    if( update && baselineFile.isEmpty() )
+    {
+        usage();
+        return 2;
+    }
+    if( benchMode )
+        return bench( corpusDir, corpus, repeat, jsonFile, baselineFile, tolerance, update );
+    if( proFile.isEmpty() )
+    {
+        usage();
+        return 2;
+    }
+    return index( proFile, quiet );
+}
@@ -0,0 +1,107 @@
+/*
+* Copyright 2019 Rochus Keller <mailto:me@rochus-keller.ch>
+*
+* This file is part of the LolaCreator plugin.
+*
+* The following is the license that applies to this copy of the
+* plugin. For a license to use the plugin under conditions
+* other than those described here, please email to me@rochus-keller.ch.
+*
+* GNU General Public License Usage
+* This file may be used under the terms of the GNU General Public
+* License (GPL) versions 2.0 or 3.0 as published by the Free Software
+* Foundation and appearing in the file LICENSE.GPL included in
+* the packaging of this file. Please review the following information
+* to ensure GNU General Public Licensing requirements will be met:
+* http://www.fsf.org/licensing/licenses/info/GPLv2.html and
+* http://www.gnu.org/copyleft/gpl.html.
+*/
+
+#include "LlMatchTable.h"
+#include <Lola/LlLexer.h>
+#include <QVector>
+using namespace Ll;
+
+MatchTable MatchTable::build(const QList<Token>& toks, const QVector<int>& lineStart, int revision)
+{
+    MatchTable res;
+    res.d_revision = revision;
+
+    enum { Bracket, Begin, If, Module };
+    struct Open
+    {
+        int d_pos;
+        int d_type;
+        int d_kind;
+    };
+    QVector<Open> stack;
+
+    foreach( const Token& t, toks )
+    {
+        if( t.d_lineNr == 0 || int(t.d_lineNr) > lineStart.size() )
+            continue;
+        const int pos = lineStart[t.d_lineNr-1] + t.d_colNr - 1;
+        switch( t.d_type )
+        {
+        case Tok_Lpar:
+        case Tok_Lbrack:
+        case Tok_Lbrace:
+            {
+                Open o = { pos, t.d_type, Bracket };
+                stack.append(o);
+            }
+            break;
+        case Tok_BEGIN:
+            {
+                Open o = { pos, t.d_type, Begin };
+                stack.append(o);
+            }
+            break;
+        case Tok_Rpar:
+        case Tok_Rbrack:
+        case Tok_Rbrace:
+            {
+                const int open = t.d_type == Tok_Rpar ? Tok_Lpar :
+                                       t.d_type == Tok_Rbrack ? Tok_Lbrack : Tok_Lbrace;
+                // an unbalanced closing bracket is a syntax error; it stays unmatched
+                if( !stack.isEmpty() && stack.last().d_type == open )
+                {
+                    res.d_pairs.insert( stack.last().d_pos, pos );
+                    res.d_pairs.insert( pos, stack.last().d_pos );
+                    stack.removeLast();
+                }
+            }
+            break;
+        case Tok_END:
+            // brackets left open up to here are errors
+            while( !stack.isEmpty() && stack.last().d_kind == Bracket )
+                stack.removeLast();
+            if( !stack.isEmpty() )
+            {
+                const Open o = stack.takeLast();
+                res.d_pairs.insert( o.d_pos, pos );
+                res.d_pairs.insert( pos, o.d_pos );
+                // the END of a module body also ends the module
+                if( o.d_kind == Begin && !stack.isEmpty() && stack.last().d_kind == Module )
+                    res.d_pairs.insert( stack.takeLast().d_pos, pos );
+            }
+            break;
+        case Tok_IF:
+            {
+                // IF ... END pairs like BEGIN ... END
+                Open o = { pos, t.d_type, If };
+                stack.append(o);
+            }
+            break;
+        case Tok_MODULE:
+            {
+                Open o = { pos, t.d_type, Module };
+                stack.append(o);
+            }
+            break;
+        default:
+            break;
+        }
+    }
+    return res;
+}
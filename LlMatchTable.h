@@ -0,0 +1,52 @@
+#ifndef LLMATCHTABLE_H
+#define LLMATCHTABLE_H
+
+/*
+* Copyright 2019 Rochus Keller <mailto:me@rochus-keller.ch>
+*
+* This file is part of the LolaCreator plugin.
+*
+* The following is the license that applies to this copy of the
+* plugin. For a license to use the plugin under conditions
+* other than those described here, please email to me@rochus-keller.ch.
+*
+* GNU General Public License Usage
+* This file may be used under the terms of the GNU General Public
+* License (GPL) versions 2.0 or 3.0 as published by the Free Software
+* Foundation and appearing in the file LICENSE.GPL included in
+* the packaging of this file. Please review the following information
+* to ensure GNU General Public Licensing requirements will be met:
+* http://www.fsf.org/licensing/licenses/info/GPLv2.html and
+* http://www.gnu.org/copyleft/gpl.html.
+*/
+
+#include <QHash>
+#include <QVector>
+#include <Lola/LlToken.h>
+
+namespace Ll
+{
+    // Pairs of matching brackets and BEGIN/IF/MODULE with their END of a file, built from the
+    // token stream so that comments are skipped; looked up by character position.
+    class MatchTable
+    {
+    public:
+        MatchTable():d_revision(-1) {}
+
+        // thread safe; lineStart holds the position of each line, revision is the one of the
+        // document the tokens were taken from
+        static MatchTable build( const QList<Token>&, const QVector<int>& lineStart, int revision );
+
+        // position of the partner of the token starting at pos, or -1
+        int match( int pos ) const { return d_pairs.value( pos, -1 ); }
+        bool contains( int pos ) const { return d_pairs.contains(pos); }
+        int revision() const { return d_revision; }
+        // both directions; an entry with pos < partner opens a range
+        const QHash<int,int>& pairs() const { return d_pairs; }
+    private:
+        QHash<int,int> d_pairs; // both directions, except MODULE which has a BEGIN
+        int d_revision;
+    };
+}
+
+#endif // LLMATCHTABLE_H
@@ -18,6 +18,8 @@
 */
 
 #include "LlModelManager.h"
+#include "LlPerfMonitor.h"
+#include "LlTraceRecorder.h"
 #include "LolaCreatorConstants.h"
 #include <Lola/LlErrors.h>
 #include <Lola/LlCrossRefModel.h>
@@ -29,7 +31,8 @@ using namespace Ll;
 
 ModelManager* ModelManager::d_inst = 0;
 
-ModelManager::ModelManager(QObject *parent) : QObject(parent),d_lastUsed(0)
+ModelManager::ModelManager(QObject *parent) : QObject(parent),
+    d_maxIdleModels(3),d_maxIdleBytes(16*1024*1024),d_lastUsed(0)
 {
     d_fcache = new FileCache(this);
     d_inst = this;
@@ -53,8 +56,11 @@ CrossRefModel*ModelManager::getModelForFile(const QString& fileName)
     {
         m = new CrossRefModel(this,d_fcache);
         connect( m, SIGNAL(sigModelUpdated()), this, SLOT(onModelUpdated()) );
+        // direct, so the trace shows the thread that parsed the file
+        connect( m, SIGNAL(sigFileUpdated(QString)), this, SLOT(onFileParsed(QString)), Qt::DirectConnection );
         d_paths[m] = fileName;
     }
+    touch(fileName);
     d_lastUsed = m;
     return m;
 }
@@ -65,14 +71,17 @@ CrossRefModel*ModelManager::getModelForDir(const QString& dirPath, bool initIfEm
         return 0;
     QFileInfo info(dirPath);
     CrossRefModel* mdl = getModelForFile( info.path() );
-    if( initIfEmpty && mdl->isEmpty() )
+    // an evicted model is transparently reparsed when it is asked for again
+    if( ( initIfEmpty || d_evicted.contains( info.path() ) ) && mdl->isEmpty() )
     {
+        d_evicted.remove( info.path() );
         QDir dir = info.dir();
         QStringList files = dir.entryList( QStringList() << QString("*.Lola")
                                                << QString("*.Mod"), QDir::Files, QDir::Name );
         for( int i = 0; i < files.size(); i++ )
             files[i] = dir.absoluteFilePath(files[i]);
-        mdl->updateFiles(files);
+        setFootprint( mdl, files );
+        updateFiles( mdl, files );
     }
     return mdl;
 }
@@ -101,6 +110,98 @@ QString ModelManager::getPathOf(CrossRefModel* m) const
     return d_paths.value(m);
 }
 
+void ModelManager::addRef(const QString& path)
+{
+    if( path.isEmpty() )
+        return;
+    if( d_refs[path]++ == 0 )
+        d_idle.removeAll(path);
+}
+
+void ModelManager::release(const QString& path)
+{
+    QHash<QString,int>::iterator i = d_refs.find(path);
+    if( i == d_refs.end() )
+        return;
+    if( --i.value() > 0 )
+        return;
+    d_refs.erase(i);
+    if( d_models.contains(path) )
+    {
+        d_idle.prepend(path);
+        evictIdle();
+    }
+}
+
+void ModelManager::setIdleBudget(int maxModels, qint64 maxBytes)
+{
+    d_maxIdleModels = qMax( 0, maxModels );
+    d_maxIdleBytes = qMax( qint64(0), maxBytes );
+    evictIdle();
+}
+
+void ModelManager::setFootprint(CrossRefModel* mdl, const QStringList& files)
+{
+    qint64 bytes = 0;
+    foreach( const QString& f, files )
+        bytes += QFileInfo(f).size();
+    d_sizes[mdl] = bytes;
+}
+
+void ModelManager::dropFiles(CrossRefModel* mdl, const QStringList& files)
+{
+    // CrossRefModel has no removal API. Parsing an empty text replaces the file's declarations and
+    // cross references in the model by none, so nothing resolves to the dropped file anymore;
+    // only an empty entry for the path remains. A file added again later is parsed from the
+    // FileCache or the disk by updateFiles
+    foreach( const QString& f, files )
+        mdl->parseString( QString(), f );
+}
+
+void ModelManager::updateFiles(CrossRefModel* mdl, const QStringList& files)
+{
+    // requests coalesced by the model are measured from the first one
+    if( PerfMonitor::isEnabled() && !d_parseTimers.contains(mdl) )
+        d_parseTimers[mdl].start();
+    TraceRecorder::tasksQueued();
+    mdl->updateFiles(files);
+}
+
+void ModelManager::touch(const QString& path)
+{
+    if( d_refs.contains(path) )
+        return;
+    // unreferenced models move to the front of the LRU list on each access
+    d_idle.removeAll(path);
+    d_idle.prepend(path);
+    evictIdle( path );
+}
+
+void ModelManager::evictIdle( const QString& keep )
+{
+    qint64 bytes = 0;
+    foreach( const QString& path, d_idle )
+        bytes += d_sizes.value( d_models.value(path) );
+
+    // keep is at the front, so it is only reached when it is the last idle model
+    while( !d_idle.isEmpty() && d_idle.last() != keep &&
+           ( d_idle.size() > d_maxIdleModels || bytes > d_maxIdleBytes ) )
+    {
+        const QString path = d_idle.takeLast();
+        CrossRefModel* mdl = d_models.take(path);
+        if( mdl == 0 )
+            continue;
+        bytes -= d_sizes.take(mdl);
+        d_paths.remove(mdl);
+        d_parseTimers.remove(mdl);
+        d_evicted.insert(path);
+        if( d_lastUsed == mdl )
+            d_lastUsed = 0;
+        emit sigModelEvicted(mdl);
+        mdl->deleteLater();
+    }
+}
+
 ModelManager*ModelManager::instance()
 {
     if( d_inst )
@@ -115,6 +216,15 @@ void ModelManager::onModelUpdated()
 
     CrossRefModel* mdl = static_cast<CrossRefModel*>( sender() );
 
+    QHash<CrossRefModel*,QElapsedTimer>::iterator t = d_parseTimers.find(mdl);
+    if( t != d_parseTimers.end() )
+    {
+        PerfMonitor::record( "CrossRefModel::updateFiles", t.value().nsecsElapsed(), d_paths.value(mdl), -1,
+                             "Code model updates" );
+        d_parseTimers.erase(t);
+    }
+    ScopedTimer timer( "ModelManager::onModelUpdated (TaskHub)", d_paths.value(mdl) );
+
     ProjectExplorer::TaskHub::clearTasks( LolaCreator::Constants::TaskId );
 
     typedef QPair<QString,quint32> FileLine;
@@ -149,3 +259,8 @@ void ModelManager::onModelUpdated()
     }
 }
 
+void ModelManager::onFileParsed(const QString& path)
+{
+    // runs on the thread emitting the signal, so it only touches the thread safe recorder
+    TraceRecorder::taskDone( "CrossRefModel parse file", path );
+}
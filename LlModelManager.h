@@ -22,11 +22,14 @@
 
 #include <QObject>
 #include <QHash>
+#include <QSet>
+#include <QElapsedTimer>
 #include <Lola/LlFileCache.h>
 #include <Lola/LlCrossRefModel.h>
 
 namespace Ll
 {
+
     class ModelManager : public QObject
     {
         Q_OBJECT
@@ -41,17 +44,46 @@ namespace Ll
         CrossRefModel* getLastUsed() const { return d_lastUsed; }
         QString getPathOf(CrossRefModel*) const;
 
+        // Open documents reference the directory path, projects their project file path;
+        // models without references are kept in an LRU list and evicted beyond the budget
+        void addRef( const QString& path );
+        void release( const QString& path );
+        void setIdleBudget( int maxModels, qint64 maxBytes );
+        void setFootprint( CrossRefModel*, const QStringList& files );
+
+        // CrossRefModel cannot forget a file, so dropped files are parsed as empty text in the
+        // given model only; the FileCache shared with other models and editors stays untouched
+        void dropFiles( CrossRefModel*, const QStringList& files );
+
+        // CrossRefModel::updateFiles; the time until sigModelUpdated goes to the PerfMonitor
+        void updateFiles( CrossRefModel*, const QStringList& files );
+
         FileCache* getFileCache() const { return d_fcache; }
 
         static ModelManager* instance();
 
+    signals:
+        void sigModelEvicted( CrossRefModel* );
+
     protected slots:
         void onModelUpdated();
+        void onFileParsed( const QString& );
+
+    protected:
+        void touch( const QString& path );
+        void evictIdle( const QString& keep = QString() ); // keep: the model being accessed
 
     private:
         static ModelManager* d_inst;
         QHash<QString,CrossRefModel*> d_models; // Project File -> Code Model
         QHash<CrossRefModel*,QString> d_paths;
+        QHash<QString,int> d_refs; // Project File or Directory -> open documents and projects
+        QHash<CrossRefModel*,qint64> d_sizes; // source bytes as an estimate of the model size
+        QList<QString> d_idle; // unreferenced models, most recently used first
+        QSet<QString> d_evicted;
+        QHash<CrossRefModel*,QElapsedTimer> d_parseTimers; // only while the PerfMonitor records
+        int d_maxIdleModels;
+        qint64 d_maxIdleBytes;
         CrossRefModel* d_lastUsed;
         FileCache* d_fcache;
     };
@@ -19,6 +19,7 @@
 
 #include "LlModuleLocator.h"
 #include "LlModelManager.h"
+#include "LlPerfMonitor.h"
 #include <coreplugin/editormanager/editormanager.h>
 #include <QDir>
 using namespace Ll;
@@ -35,6 +36,7 @@ QList<Core::LocatorFilterEntry> ModuleLocator::matchesFor(QFutureInterface<Core:
                                                           const QString& entry)
 {
     Q_UNUSED(future);
+    ScopedTimer timer( "ModuleLocator::matchesFor", entry );
 
     QList<Core::LocatorFilterEntry> res;
 
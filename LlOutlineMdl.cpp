@@ -19,14 +19,16 @@
 
 #include "LlOutlineMdl.h"
 #include "LlModelManager.h"
+#include "LlPerfMonitor.h"
 #include <Lola/LlSynTree.h>
 #include <QPixmap>
 #include <QtDebug>
 using namespace Ll;
 
-OutlineMdl1::OutlineMdl1(QObject *parent) : QAbstractItemModel(parent),d_crm(0)
+OutlineMdl1::OutlineMdl1(QObject *parent) : QAbstractItemModel(parent),d_crm(0),d_lazy(false),d_dirty(false)
 {
-
+    connect( ModelManager::instance(), SIGNAL(sigModelEvicted(CrossRefModel*)),
+             this, SLOT(onCrmEvicted(CrossRefModel*)) );
 }
 
 void OutlineMdl1::setFile(const QString& f)
@@ -39,12 +41,26 @@ void OutlineMdl1::setFile(const QString& f)
         disconnect( d_crm, SIGNAL(sigFileUpdated(QString)), this, SLOT( onCrmUpdated(QString) ) );
     d_file = f;
     d_crm = ModelManager::instance()->getModelForCurrentProjectOrDirPath(f);
-    fillTop();
+    d_dirty = d_lazy;
+    if( !d_lazy )
+        fillTop();
     if( d_crm )
         connect( d_crm, SIGNAL(sigFileUpdated(QString)), this, SLOT( onCrmUpdated(QString) ) );
     endResetModel();
 }
 
+void OutlineMdl1::refresh()
+{
+    if( !d_dirty )
+        return;
+    d_dirty = false;
+    ScopedTimer timer( "OutlineMdl1::refresh", d_file );
+    beginResetModel();
+    d_rows.clear();
+    fillTop();
+    endResetModel();
+}
+
 const CrossRefModel::Symbol*OutlineMdl1::getSymbol(const QModelIndex& index) const
 {
     if( !index.isValid() || d_crm == 0 )
@@ -163,12 +179,29 @@ void OutlineMdl1::onCrmUpdated(const QString& file)
 {
     if( file != d_file )
         return;
+    if( d_lazy )
+    {
+        d_dirty = true;
+        return;
+    }
+    ScopedTimer timer( "OutlineMdl1::onCrmUpdated (reset)", file );
     beginResetModel();
     d_rows.clear();
     fillTop();
     endResetModel();
 }
 
+void OutlineMdl1::onCrmEvicted(CrossRefModel* crm)
+{
+    if( crm != d_crm )
+        return;
+    beginResetModel();
+    d_rows.clear();
+    d_crm = 0;
+    d_file.clear(); // next setFile fetches a fresh model
+    endResetModel();
+}
+
 void OutlineMdl1::fillTop()
 {
     if( d_crm == 0 )
@@ -221,7 +254,8 @@ void OutlineMdl1::fillSubs( const CrossRefModel::Branch* b, const QByteArray& na
 OutlineMdl2::OutlineMdl2(QObject *parent) :
     QAbstractItemModel(parent),d_crm(0)
 {
-
+    connect( ModelManager::instance(), SIGNAL(sigModelEvicted(CrossRefModel*)),
+             this, SLOT(onCrmEvicted(CrossRefModel*)) );
 }
 
 void OutlineMdl2::setFile(const QString& f)
@@ -343,12 +377,24 @@ void OutlineMdl2::onCrmUpdated(const QString& file)
 {
     if( file != d_file )
         return;
+    ScopedTimer timer( "OutlineMdl2::onCrmUpdated (reset)", file );
     beginResetModel();
     d_root = Slot();
     fillTop();
     endResetModel();
 }
 
+void OutlineMdl2::onCrmEvicted(CrossRefModel* crm)
+{
+    if( crm != d_crm )
+        return;
+    beginResetModel();
+    d_root = Slot();
+    d_crm = 0;
+    d_file.clear();
+    endResetModel();
+}
+
 void OutlineMdl2::fillTop()
 {
     if( d_crm == 0 )
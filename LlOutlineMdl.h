@@ -33,6 +33,10 @@ namespace Ll
 
         void setFile( const QString& );
 
+        // lazy models are only filled by refresh, e.g. when the user opens the combo box
+        void setLazy( bool on ) { d_lazy = on; }
+        void refresh();
+
         const CrossRefModel::Symbol* getSymbol( const QModelIndex & ) const;
         QModelIndex findSymbol( const CrossRefModel::Symbol* );
         QModelIndex findSymbol( quint32 line, quint16 col );
@@ -47,6 +51,7 @@ namespace Ll
 
     protected slots:
         void onCrmUpdated(const QString&);
+        void onCrmEvicted(CrossRefModel*);
 
     protected:
         void fillTop();
@@ -62,6 +67,8 @@ namespace Ll
         QList<Slot> d_rows;
         QString d_file;
         CrossRefModel* d_crm;
+        bool d_lazy;
+        bool d_dirty;
     };
 
     class OutlineMdl2 : public QAbstractItemModel
@@ -84,6 +91,7 @@ namespace Ll
 
     protected slots:
         void onCrmUpdated(const QString& file);
+        void onCrmEvicted(CrossRefModel*);
 
     private:
         struct Slot
@@ -0,0 +1,151 @@
+/*
+* Copyright 2019 Rochus Keller <mailto:me@rochus-keller.ch>
+*
+* This file is part of the LolaCreator plugin.
+*
+* The following is the license that applies to this copy of the
+* plugin. For a license to use the plugin under conditions
+* other than those described here, please email to me@rochus-keller.ch.
+*
+* GNU General Public License Usage
+* This file may be used under the terms of the GNU General Public
+* License (GPL) versions 2.0 or 3.0 as published by the Free Software
+* Foundation and appearing in the file LICENSE.GPL included in
+* the packaging of this file. Please review the following information
+* to ensure GNU General Public Licensing requirements will be met:
+* http://www.fsf.org/licensing/licenses/info/GPLv2.html and
+* http://www.gnu.org/copyleft/gpl.html.
+*/
+
+#include "LlPerfMonitor.h"
+#include "LlTraceRecorder.h"
+#include <QMutex>
+#include <QHash>
+#include <QVector>
+#include <algorithm>
+using namespace Ll;
+
+QAtomicInt PerfMonitor::s_flags;
+
+static const int s_ringSize = 1024;
+static const int s_worstCount = 5;
+
+namespace
+{
+    struct Series
+    {
+        QVector<qint64> d_ring;
+        int d_pos;
+        quint32 d_count;
+        qint64 d_total, d_max;
+        QList<PerfMonitor::Sample> d_worst;
+        Series():d_pos(0),d_count(0),d_total(0),d_max(0) {}
+    };
+}
+
+static QMutex s_lock;
+static QHash<QByteArray,Series> s_series; // the keys point to the name literals
+
+void PerfMonitor::setEnabled(bool on)
+{
+    setFlag( Statistics, on );
+}
+
+void PerfMonitor::setFlag(PerfMonitor::Flag f, bool on)
+{
+    int old;
+    do
+    {
+        old = s_flags.load();
+    }while( !s_flags.testAndSetOrdered( old, on ? ( old | f ) : ( old & ~f ) ) );
+}
+
+static QElapsedTimer startClock()
+{
+    QElapsedTimer t;
+    t.start();
+    return t;
+}
+
+qint64 PerfMonitor::now()
+{
+    static const QElapsedTimer clock = startClock();
+    return clock.nsecsElapsed();
+}
+
+static bool slowerThan( const PerfMonitor::Sample& lhs, const PerfMonitor::Sample& rhs )
+{
+    return lhs.d_ms > rhs.d_ms;
+}
+
+void PerfMonitor::record(const char* name, qint64 nsecs, const QString& detail, qint64 start, const char* track)
+{
+    if( isEnabled(Tracing) )
+        TraceRecorder::complete( name, start < 0 ? now() - nsecs : start, nsecs, detail, track );
+    if( !isEnabled(Statistics) )
+        return;
+    QMutexLocker guard(&s_lock);
+    Series& s = s_series[ QByteArray::fromRawData( name, int(qstrlen(name)) ) ];
+    if( s.d_ring.size() < s_ringSize )
+        s.d_ring.append(nsecs);
+    else
+        s.d_ring[s.d_pos] = nsecs;
+    s.d_pos = ( s.d_pos + 1 ) % s_ringSize;
+    s.d_count++;
+    s.d_total += nsecs;
+    s.d_max = qMax( s.d_max, nsecs );
+    const double ms = nsecs / 1000000.0;
+    if( s.d_worst.size() < s_worstCount || ms > s.d_worst.last().d_ms )
+    {
+        Sample sample;
+        sample.d_ms = ms;
+        sample.d_detail = detail;
+        s.d_worst.insert( std::upper_bound( s.d_worst.begin(), s.d_worst.end(), sample, slowerThan ), sample );
+        if( s.d_worst.size() > s_worstCount )
+            s.d_worst.removeLast();
+    }
+}
+
+static double percentile( const QVector<qint64>& sorted, int p )
+{
+    if( sorted.isEmpty() )
+        return 0;
+    const int i = qMin( sorted.size() - 1, ( sorted.size() * p ) / 100 );
+    return sorted[i] / 1000000.0;
+}
+
+static bool moreTotal( const PerfMonitor::Stat& lhs, const PerfMonitor::Stat& rhs )
+{
+    return lhs.d_totalMs > rhs.d_totalMs;
+}
+
+QList<PerfMonitor::Stat> PerfMonitor::stats()
+{
+    QList<Stat> res;
+    QMutexLocker guard(&s_lock);
+    for( QHash<QByteArray,Series>::const_iterator i = s_series.begin(); i != s_series.end(); ++i )
+    {
+        const Series& s = i.value();
+        QVector<qint64> sorted = s.d_ring;
+        std::sort( sorted.begin(), sorted.end() );
+        Stat st;
+        st.d_name = QByteArray( i.key().constData(), i.key().size() );
+        st.d_count = s.d_count;
+        st.d_totalMs = s.d_total / 1000000.0;
+        st.d_p50 = percentile( sorted, 50 );
+        st.d_p95 = percentile( sorted, 95 );
+        st.d_p99 = percentile( sorted, 99 );
+        st.d_maxMs = s.d_max / 1000000.0;
+        st.d_worst = s.d_worst;
+        res.append(st);
+    }
+    guard.unlock();
+    std::sort( res.begin(), res.end(), moreTotal );
+    return res;
+}
+
+void PerfMonitor::reset()
+{
+    QMutexLocker guard(&s_lock);
+    s_series.clear();
+}
@@ -0,0 +1,92 @@
+#ifndef LLPERFMONITOR_H
+#define LLPERFMONITOR_H
+
+/*
+* Copyright 2019 Rochus Keller <mailto:me@rochus-keller.ch>
+*
+* This file is part of the LolaCreator plugin.
+*
+* The following is the license that applies to this copy of the
+* plugin. For a license to use the plugin under conditions
+* other than those described here, please email to me@rochus-keller.ch.
+*
+* GNU General Public License Usage
+* This file may be used under the terms of the GNU General Public
+* License (GPL) versions 2.0 or 3.0 as published by the Free Software
+* Foundation and appearing in the file LICENSE.GPL included in
+* the packaging of this file. Please review the following information
+* to ensure GNU General Public Licensing requirements will be met:
+* http://www.fsf.org/licensing/licenses/info/GPLv2.html and
+* http://www.gnu.org/copyleft/gpl.html.
+*/
+
+#include <QAtomicInt>
+#include <QElapsedTimer>
+#include <QStringList>
+
+namespace Ll
+{
+    // Latency statistics of the hot paths. Recording is off by default; a disabled ScopedTimer
+    // costs one atomic load. The last samples of each stage are kept in a ring buffer. While the
+    // TraceRecorder is running the samples also go to the trace.
+    class PerfMonitor
+    {
+    public:
+        struct Sample
+        {
+            double d_ms;
+            QString d_detail; // e.g. the file
+        };
+        struct Stat
+        {
+            QByteArray d_name;
+            quint32 d_count;
+            double d_totalMs, d_p50, d_p95, d_p99, d_maxMs; // the percentiles cover the ring buffer
+            QList<Sample> d_worst; // slowest first
+        };
+
+        enum Flag { Statistics = 1, Tracing = 2 };
+        static bool isEnabled() { return s_flags.load() != 0; }
+        static bool isEnabled( Flag f ) { return ( s_flags.load() & f ) != 0; }
+        static void setEnabled( bool ); // Statistics
+        static void setFlag( Flag, bool );
+        // monotonic nanoseconds, the time base of the samples
+        static qint64 now();
+        // name must be a string literal; start is now() at the beginning, by default now() - nsecs;
+        // asynchronous spans name their own track in the trace
+        static void record( const char* name, qint64 nsecs, const QString& detail = QString(),
+                            qint64 start = -1, const char* track = 0 );
+        // sorted by total time, largest first
+        static QList<Stat> stats();
+        static void reset();
+    private:
+        PerfMonitor() {}
+        static QAtomicInt s_flags;
+    };
+
+    class ScopedTimer
+    {
+    public:
+        explicit ScopedTimer( const char* name, const QString& detail = QString() ):
+            d_name( PerfMonitor::isEnabled() ? name : 0 )
+        {
+            if( d_name )
+            {
+                d_detail = detail;
+                d_start = PerfMonitor::now();
+            }
+        }
+        ~ScopedTimer()
+        {
+            if( d_name )
+                PerfMonitor::record( d_name, PerfMonitor::now() - d_start, d_detail, d_start );
+        }
+    private:
+        Q_DISABLE_COPY(ScopedTimer)
+        const char* d_name;
+        QString d_detail;
+        qint64 d_start;
+    };
+}
+
+#endif // LLPERFMONITOR_H
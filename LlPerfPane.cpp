@@ -0,0 +1,200 @@
+/*
+* Copyright 2019 Rochus Keller <mailto:me@rochus-keller.ch>
+*
+* This file is part of the LolaCreator plugin.
+*
+* The following is the license that applies to this copy of the
+* plugin. For a license to use the plugin under conditions
+* other than those described here, please email to me@rochus-keller.ch.
+*
+* GNU General Public License Usage
+* This file may be used under the terms of the GNU General Public
+* License (GPL) versions 2.0 or 3.0 as published by the Free Software
+* Foundation and appearing in the file LICENSE.GPL included in
+* the packaging of this file. Please review the following information
+* to ensure GNU General Public Licensing requirements will be met:
+* http://www.fsf.org/licensing/licenses/info/GPLv2.html and
+* http://www.gnu.org/copyleft/gpl.html.
+*/
+
+#include "LlPerfPane.h"
+#include "LlPerfMonitor.h"
+#include "LlTraceRecorder.h"
+#include <coreplugin/messagemanager.h>
+#include <QTreeWidget>
+#include <QHeaderView>
+#include <QToolButton>
+#include <QAction>
+#include <QSet>
+#include <QDir>
+using namespace Ll;
+
+enum { NameCol, CountCol, TotalCol, P50Col, P95Col, P99Col, MaxCol, ColCount };
+
+PerfPane::PerfPane(QObject* parent):IOutputPane(parent),d_tree(0),d_visible(false)
+{
+    d_record = new QAction(tr("Record Lola Performance"), this);
+    d_record->setCheckable(true);
+    d_record->setToolTip(tr("Measure the latency of the editor and code model operations"));
+    connect( d_record, SIGNAL(toggled(bool)), this, SLOT(onRecord(bool)) );
+
+    d_trace = new QAction(tr("Record Lola Trace"), this);
+    d_trace->setCheckable(true);
+    d_trace->setToolTip(tr("Write a Chrome trace of the plugin activity to the temp directory"));
+    connect( d_trace, SIGNAL(toggled(bool)), this, SLOT(onTrace(bool)) );
+
+    d_recordButton = new QToolButton();
+    d_recordButton->setDefaultAction(d_record);
+    d_recordButton->setText(tr("Record"));
+
+    d_traceButton = new QToolButton();
+    d_traceButton->setDefaultAction(d_trace);
+    d_traceButton->setText(tr("Trace"));
+
+    d_resetButton = new QToolButton();
+    d_resetButton->setText(tr("Reset"));
+    d_resetButton->setToolTip(tr("Discard the recorded samples"));
+    connect( d_resetButton, SIGNAL(clicked()), this, SLOT(onReset()) );
+
+    d_refreshTimer.setInterval(1000);
+    connect( &d_refreshTimer, SIGNAL(timeout()), this, SLOT(onRefresh()) );
+}
+
+PerfPane::~PerfPane()
+{
+    PerfMonitor::setEnabled(false);
+    if( TraceRecorder::isRecording() )
+        TraceRecorder::stop();
+    delete d_tree;
+    delete d_recordButton;
+    delete d_traceButton;
+    delete d_resetButton;
+}
+
+QWidget*PerfPane::outputWidget(QWidget* parent)
+{
+    if( d_tree == 0 )
+    {
+        d_tree = new QTreeWidget(parent);
+        d_tree->setColumnCount(ColCount);
+        d_tree->setHeaderLabels( QStringList() << tr("Stage / worst samples") << tr("Count") << tr("Total ms")
+                                 << tr("p50 ms") << tr("p95 ms") << tr("p99 ms") << tr("Max ms") );
+        d_tree->setAlternatingRowColors(true);
+        d_tree->setUniformRowHeights(true);
+        d_tree->header()->setStretchLastSection(false);
+        d_tree->header()->setSectionResizeMode(NameCol, QHeaderView::Stretch);
+        onRefresh();
+    }
+    return d_tree;
+}
+
+QList<QWidget*> PerfPane::toolBarWidgets() const
+{
+    return QList<QWidget*>() << d_recordButton << d_traceButton << d_resetButton;
+}
+
+QString PerfPane::displayName() const
+{
+    return tr("Lola Performance");
+}
+
+void PerfPane::clearContents()
+{
+    PerfMonitor::reset();
+    onRefresh();
+}
+
+void PerfPane::onReset()
+{
+    clearContents();
+}
+
+void PerfPane::visibilityChanged(bool visible)
+{
+    d_visible = visible;
+    if( d_visible && d_record->isChecked() )
+        d_refreshTimer.start();
+    else
+        d_refreshTimer.stop();
+    if( d_visible )
+        onRefresh();
+}
+
+void PerfPane::setFocus()
+{
+    if( d_tree )
+        d_tree->setFocus();
+}
+
+bool PerfPane::hasFocus() const
+{
+    return d_tree && d_tree->window()->focusWidget() == d_tree;
+}
+
+static QString ms( double v )
+{
+    return QString::number( v, 'f', v < 10.0 ? 3 : 1 );
+}
+
+void PerfPane::onRefresh()
+{
+    if( d_tree == 0 )
+        return;
+    // keep the expanded stages expanded
+    QSet<QString> expanded;
+    for( int i = 0; i < d_tree->topLevelItemCount(); i++ )
+    {
+        if( d_tree->topLevelItem(i)->isExpanded() )
+            expanded.insert( d_tree->topLevelItem(i)->text(NameCol) );
+    }
+    d_tree->clear();
+    foreach( const PerfMonitor::Stat& s, PerfMonitor::stats() )
+    {
+        QTreeWidgetItem* item = new QTreeWidgetItem(d_tree);
+        item->setText( NameCol, QString::fromLatin1(s.d_name) );
+        item->setText( CountCol, QString::number(s.d_count) );
+        item->setText( TotalCol, ms(s.d_totalMs) );
+        item->setText( P50Col, ms(s.d_p50) );
+        item->setText( P95Col, ms(s.d_p95) );
+        item->setText( P99Col, ms(s.d_p99) );
+        item->setText( MaxCol, ms(s.d_maxMs) );
+        for( int c = CountCol; c < ColCount; c++ )
+            item->setTextAlignment( c, Qt::AlignRight | Qt::AlignVCenter );
+        foreach( const PerfMonitor::Sample& w, s.d_worst )
+        {
+            QTreeWidgetItem* sub = new QTreeWidgetItem(item);
+            sub->setText( NameCol, w.d_detail.isEmpty() ? tr("<no detail>") : w.d_detail );
+            sub->setText( MaxCol, ms(w.d_ms) );
+            sub->setTextAlignment( MaxCol, Qt::AlignRight | Qt::AlignVCenter );
+        }
+        item->setExpanded( expanded.contains( item->text(NameCol) ) );
+    }
+    for( int c = CountCol; c < ColCount; c++ )
+        d_tree->resizeColumnToContents(c);
+}
+
+void PerfPane::onRecord(bool on)
+{
+    PerfMonitor::setEnabled(on);
+    if( on && d_visible )
+        d_refreshTimer.start();
+    else
+        d_refreshTimer.stop();
+    if( !on )
+        onRefresh();
+}
+
+void PerfPane::onTrace(bool on)
+{
+    if( on )
+    {
+        TraceRecorder::start();
+        return;
+    }
+    const QString path = TraceRecorder::stop();
+    if( path.isEmpty() )
+        Core::MessageManager::write(tr("Lola trace could not be written to %1").arg(QDir::tempPath()));
+    else
+        Core::MessageManager::write(tr("Lola trace written to %1; open it in chrome://tracing or "
+                                       "ui.perfetto.dev").arg(path));
+}
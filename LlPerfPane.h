@@ -0,0 +1,76 @@
+#ifndef LLPERFPANE_H
+#define LLPERFPANE_H
+
+/*
+* Copyright 2019 Rochus Keller <mailto:me@rochus-keller.ch>
+*
+* This file is part of the LolaCreator plugin.
+*
+* The following is the license that applies to this copy of the
+* plugin. For a license to use the plugin under conditions
+* other than those described here, please email to me@rochus-keller.ch.
+*
+* GNU General Public License Usage
+* This file may be used under the terms of the GNU General Public
+* License (GPL) versions 2.0 or 3.0 as published by the Free Software
+* Foundation and appearing in the file LICENSE.GPL included in
+* the packaging of this file. Please review the following information
+* to ensure GNU General Public Licensing requirements will be met:
+* http://www.fsf.org/licensing/licenses/info/GPLv2.html and
+* http://www.gnu.org/copyleft/gpl.html.
+*/
+
+#include <coreplugin/ioutputpane.h>
+#include <QTimer>
+
+class QTreeWidget;
+class QAction;
+class QToolButton;
+
+namespace Ll
+{
+    // "Lola Performance" output pane showing the PerfMonitor statistics
+    class PerfPane : public Core::IOutputPane
+    {
+        Q_OBJECT
+    public:
+        explicit PerfPane(QObject* parent = 0);
+        ~PerfPane();
+
+        // checkable; switch PerfMonitor statistics and TraceRecorder recording on and off
+        QAction* recordAction() const { return d_record; }
+        QAction* traceAction() const { return d_trace; }
+
+        // overrides
+        QWidget* outputWidget(QWidget* parent) Q_DECL_OVERRIDE;
+        QList<QWidget*> toolBarWidgets() const Q_DECL_OVERRIDE;
+        QString displayName() const Q_DECL_OVERRIDE;
+        int priorityInStatusBar() const Q_DECL_OVERRIDE { return -1; }
+        void clearContents() Q_DECL_OVERRIDE;
+        void visibilityChanged(bool visible) Q_DECL_OVERRIDE;
+        void setFocus() Q_DECL_OVERRIDE;
+        bool hasFocus() const Q_DECL_OVERRIDE;
+        bool canFocus() const Q_DECL_OVERRIDE { return true; }
+        bool canNavigate() const Q_DECL_OVERRIDE { return false; }
+        bool canNext() const Q_DECL_OVERRIDE { return false; }
+        bool canPrevious() const Q_DECL_OVERRIDE { return false; }
+        void goToNext() Q_DECL_OVERRIDE {}
+        void goToPrev() Q_DECL_OVERRIDE {}
+    protected slots:
+        void onRefresh();
+        void onRecord(bool);
+        void onReset();
+        void onTrace(bool);
+    private:
+        QTreeWidget* d_tree;
+        QAction* d_record;
+        QAction* d_trace;
+        QToolButton* d_recordButton;
+        QToolButton* d_traceButton;
+        QToolButton* d_resetButton;
+        QTimer d_refreshTimer;
+        bool d_visible;
+    };
+}
+
+#endif // LLPERFPANE_H
@@ -19,7 +19,9 @@
 
 #include "LlProject.h"
 #include "LlModelManager.h"
-#include "LlProjectFile.h"
+#include "LlProjectLoader.h"
+#include "LlDirScanner.h"
+#include "LlPerfMonitor.h"
 #include "LolaCreatorConstants.h"
 #include <Lola/LlCrossRefModel.h>
 #include <Lola/LlErrors.h>
@@ -30,6 +32,8 @@
 #include <projectexplorer/kitmanager.h>
 #include <projectexplorer/runconfiguration.h>
 #include <coreplugin/icontext.h>
+#include <coreplugin/progressmanager/progressmanager.h>
+#include <QtConcurrentRun>
 
 namespace Ll
 {
@@ -61,7 +65,8 @@ using namespace Ll;
 const char* Project::ID = "LolaCreator.Project";
 
 Project::Project(ProjectManager* projectManager, const QString& fileName):
-    d_projectManager(projectManager),d_root(0)
+    d_projectManager(projectManager),d_root(0),d_libsFolder(0),d_sourceFolder(0),
+    d_parsing(0),d_parsed(0),d_parseTotal(0),d_evalForce(false),d_evalPending(false),d_loaded(false)
 {
     setId(ID);
     setProjectContext(Core::Context("LolaCreator.ProjectContext"));
@@ -72,9 +77,31 @@ Project::Project(ProjectManager* projectManager, const QString& fileName):
     d_name = QFileInfo(fileName).baseName();
     d_root = new ProjectNode(Utils::FileName::fromString(fileName));
     d_root->setDisplayName(d_name);
+    ModelManager::instance()->addRef(fileName);
+    connect( &d_evalWatcher, SIGNAL(finished()), this, SLOT(onEvaluated()) );
+    connect( &d_progressWatcher, SIGNAL(canceled()), this, SLOT(onLoadCanceled()) );
+    d_fillTimer.setSingleShot(true);
+    d_fillTimer.setInterval(0);
+    connect( &d_fillTimer, SIGNAL(timeout()), this, SLOT(onFillNodes()) );
     loadProject(fileName);
     d_watcher.addPath(fileName);
     connect( &d_watcher, SIGNAL(fileChanged(QString)), this, SLOT(onFileChanged(QString)) );
+    connect( &d_watcher, SIGNAL(directoryChanged(QString)), this, SLOT(onDirChanged(QString)) );
+    // coalesce bursts of directory events, e.g. from a code generator
+    d_rescanTimer.setSingleShot(true);
+    d_rescanTimer.setInterval(300);
+    connect( &d_rescanTimer, SIGNAL(timeout()), this, SLOT(onRescan()) );
+    connect( &d_rescanWatcher, SIGNAL(finished()), this, SLOT(onRescanned()) );
+}
+
+Project::~Project()
+{
+    // a running evaluation does not touch the project and may finish on its own
+    d_evalWatcher.disconnect(this);
+    d_rescanWatcher.disconnect(this);
+    finishProgress();
+    DirScanner::invalidate(d_watchedDirs);
+    ModelManager::instance()->release(d_document->filePath().toString());
 }
 
 QStringList Project::getConfig(const QString& key) const
@@ -98,7 +125,7 @@ QString Project::getTopMod() const
 
 void Project::reload()
 {
-    loadProject(d_document->filePath().toString());
+    loadProject(d_document->filePath().toString(), true);
 }
 
 QString Project::displayName() const
@@ -153,8 +180,121 @@ void Project::populateDir(const QDir& dir, ProjectExplorer::FolderNode* parent )
     d_srcFiles += files;
 }
 
-void Project::loadProject(const QString& fileName)
+// Load progress in per mille; parsing takes the major part
+static const int s_progDiscover = 50;
+static const int s_progParse = 100;
+static const int s_progResolve = 950;
+static const int s_progDone = 1000;
+static const int s_nodesPerStep = 500;
+
+ProjectLoader::Result Project::evaluate(QFutureInterface<void> progress, const QString& fileName)
+{
+    // Runs on a worker thread and only depends on its arguments
+    ScopedTimer timer( "Project::evaluate", fileName );
+    ProjectLoader::Result res = ProjectLoader::evaluate( fileName );
+    if( !res.d_ok || progress.isCanceled() )
+        return res;
+    progress.setProgressValueAndText( s_progDiscover, tr("Discovering files") );
+    ProjectLoader::discover( fileName, res );
+    return res;
+}
+
+void Project::loadProject(const QString& fileName, bool force)
+{
+    if( d_evalWatcher.isRunning() )
+    {
+        // the result would be outdated; evaluate again when the running one is done
+        d_evalPending = true;
+        d_evalForce = d_evalForce || force;
+        return;
+    }
+    startProgress();
+    d_evalForce = force;
+    d_evalWatcher.setFuture( QtConcurrent::run( &Project::evaluate, d_progress, fileName ) );
+}
+
+void Project::startProgress()
+{
+    if( d_progress.isRunning() && !d_progress.isCanceled() && d_parsing == 0 )
+        return; // still evaluating, e.g. a queued reload
+    finishProgress();
+    d_progress = QFutureInterface<void>();
+    d_progress.setProgressRange( 0, s_progDone );
+    d_progress.reportStarted();
+    d_progress.setProgressValueAndText( 0, tr("Evaluating project file") );
+    d_progressWatcher.setFuture( d_progress.future() );
+    Core::ProgressManager::addTask( d_progress.future(), tr("Loading %1").arg(d_name),
+                                    LolaCreator::Constants::LoadTaskId );
+}
+
+void Project::finishProgress()
+{
+    if( d_parsing )
+    {
+        disconnect( d_parsing, SIGNAL(sigFileUpdated(QString)), this, SLOT(onFileParsed(QString)) );
+        disconnect( d_parsing, SIGNAL(sigModelUpdated()), this, SLOT(onModelParsed()) );
+        d_parsing = 0;
+    }
+    if( d_progress.isRunning() )
+    {
+        d_progress.setProgressValue( s_progDone );
+        d_progress.reportFinished();
+    }
+}
+
+void Project::onEvaluated()
 {
+    const QString fileName = d_document->filePath().toString();
+    ScopedTimer timer( "Project::onEvaluated", fileName );
+    const bool force = d_evalForce;
+    d_evalForce = false;
+    if( d_evalPending )
+    {
+        d_evalPending = false;
+        loadProject( fileName, force );
+        return;
+    }
+    if( d_progress.isCanceled() )
+    {
+        // the project keeps its previous state
+        finishProgress();
+        return;
+    }
+    applyProject( fileName, d_evalWatcher.result(), force );
+}
+
+void Project::onLoadCanceled()
+{
+    // A running evaluation is discarded when it finishes; a running parse cannot be stopped,
+    // but the model is already usable with the files parsed so far
+    if( !d_evalWatcher.isRunning() )
+        finishProgress();
+}
+
+void Project::applyProject(const QString& fileName, const ProjectLoader::Result& eval, bool force)
+{
+    const bool ok = eval.d_ok;
+    const QMap<QString, QStringList>& config = eval.d_config;
+
+    const QDir base( QFileInfo(fileName).absolutePath() );
+
+    QStringList defs = config.value("DEFINES");
+    defs.sort();
+
+    flushFileNodes();
+
+    if( ok && !force && d_loaded && defs == d_defines )
+    {
+        // Nothing the parser depends on changed; files staying in the project keep their
+        // parse results and tree nodes
+        d_config = config;
+        resolveIncDirs( base );
+        watchDirs( eval.d_dirs );
+        applyFileDelta( base, eval.d_libFiles, eval.d_srcFiles );
+        finishProgress();
+        return;
+    }
+
     d_root->removeFolderNodes( d_root->subFolderNodes() );
     d_root->removeFileNodes( d_root->fileNodes() );
 
@@ -165,236 +305,199 @@ void Project::loadProject(const QString& fileName)
     d_libFiles.clear();
     d_incDirs.clear();
     d_config.clear();
+    d_defines.clear();
+    d_loaded = false;
 
     d_root->addFileNodes(QList<ProjectExplorer::FileNode*>() <<
                          new ProjectExplorer::FileNode(Utils::FileName::fromString(fileName),
                                                        ProjectExplorer::ProjectFileType, false ) );
 
-    ProjectExplorer::FolderNode* libsFolder = new ProjectExplorer::FolderNode(Utils::FileName::fromString("Libraries"));
-    d_root->addFolderNodes(QList<ProjectExplorer::FolderNode*>() << libsFolder);
-
-    ProjectExplorer::FolderNode* sourceFolder = new ProjectExplorer::FolderNode(Utils::FileName::fromString("Sources"));
-    d_root->addFolderNodes(QList<ProjectExplorer::FolderNode*>() << sourceFolder);
+    d_libsFolder = new ProjectExplorer::FolderNode(Utils::FileName::fromString("Libraries"));
+    d_root->addFolderNodes(QList<ProjectExplorer::FolderNode*>() << d_libsFolder);
 
-    d_config["SRCEXT"] << ".Lola"; // Preset
-    d_config["LIBEXT"] << ".Lola";
+    d_sourceFolder = new ProjectExplorer::FolderNode(Utils::FileName::fromString("Sources"));
+    d_root->addFolderNodes(QList<ProjectExplorer::FolderNode*>() << d_sourceFolder);
 
-    ProjectFile p( d_config );
-    if( !p.read(fileName) )
+    if( !ok )
+    {
+        finishProgress();
         return; // TODO: Error Message
+    }
 
-    d_config = p.variables();
-    //qDebug() << d_config; // TEST
-
-    QStringList defs = d_config.value("DEFINES");
-    defs.sort();
+    d_config = config;
+    d_defines = defs;
     for( int i = 0; i < defs.size(); i++ )
     {
         defs[i] = "`define " + defs[i];
     }
     if( !mdl->parseString(  defs.join('\n'), fileName ) )
     {
+        finishProgress();
         return;
     }
 
-    const QString oldCur = QDir::currentPath();
-    QDir::setCurrent(QFileInfo(fileName).path());
-
-    const QStringList incDirs = d_config.value("INCDIRS");
-    foreach( const QString& d, incDirs )
-    {
-        QFileInfo info(d);
-        QString path;
-        if( info.isRelative() )
-            path = QDir::cleanPath( QDir::current().absoluteFilePath(d) );
-        else
-            path = info.canonicalPath();
-        if( !d_incDirs.contains(path) )
-        {
-            d_incDirs.append(path);
-        }
-    }
+    resolveIncDirs( base );
 
     //mdl->getFcache()->setSvSuffix(d_config["SVEXT"]);
     //mdl->getFcache()->setSupportSvExt(d_config["CONFIG"].contains("UseSvExtension") );
 
-    QStringList filter = d_config["LIBEXT"];
-    for( int i = 0; i < filter.size(); i++ )
-        filter[i] = "*" + filter[i];
-
-    QSet<QString> files;
-
-    QStringList libFiles = d_config.value("LIBFILES");
-    QStringList libDirs = d_config.value("LIBDIRS");
-
-    findFilesInDirs( libDirs, filter, files );
-    QDir lastDir = QDir::current();
-    foreach( const QString& f, libFiles )
-    {
-        QFileInfo info(f);
-        if( info.isDir() )
-        {
-            if( info.isRelative() )
-                lastDir = QDir::current().absoluteFilePath(f);
-            else
-                lastDir = info.absoluteDir();
-        }else
-        {
-            if( info.isRelative() )
-                files.insert( lastDir.absoluteFilePath(f) );
-            else
-                files.insert(f);
-        }
-    }
-    libFiles = files.toList();
-    libFiles.sort();
-
-    fillNode( libFiles, libsFolder );
-    d_libFiles = libFiles;
+    watchDirs( eval.d_dirs );
 
-    filter = d_config["SRCEXT"];
-    for( int i = 0; i < filter.size(); i++ )
-        filter[i] = "*" + filter[i];
+    d_libFiles = eval.d_libFiles;
+    d_srcFiles = eval.d_srcFiles;
 
-    files.clear();
-    QStringList srcFiles = d_config.value("SRCFILES");
-    QStringList srcDirs = d_config.value("SRCDIRS");
-    if( srcFiles.isEmpty() && ( srcDirs.isEmpty() || srcDirs.first().startsWith('-') ) )
-        srcDirs.prepend(".*");
+    // the tree is filled in steps so the GUI stays responsive with large projects
+    d_pendingLibs = d_libFiles;
+    d_pendingSrcs = d_srcFiles;
+    d_fillTimer.start();
 
-    findFilesInDirs( srcDirs, filter, files );
-    lastDir = QDir::current();
-    foreach( const QString& f, srcFiles )
+    ModelManager::instance()->setFootprint( mdl, d_srcFiles + d_libFiles );
+    d_parsed = 0;
+    d_parseTotal = d_srcFiles.size() + d_libFiles.size();
+    if( d_parseTotal > 0 && d_progress.isRunning() && !d_progress.isCanceled() )
     {
-        QFileInfo info(f);
-        if( info.isDir() )
-        {
-            if( info.isRelative() )
-                lastDir = QDir::current().absoluteFilePath(f);
-            else
-                lastDir = info.absoluteDir();
-        }else
-        {
-            if( info.isRelative() )
-                files.insert( lastDir.absoluteFilePath(f) );
-            else
-                files.insert(f);
-        }
-    }
-    srcFiles = files.toList();
-    srcFiles.sort();
+        d_parsing = mdl;
+        connect( mdl, SIGNAL(sigFileUpdated(QString)), this, SLOT(onFileParsed(QString)) );
+        connect( mdl, SIGNAL(sigModelUpdated()), this, SLOT(onModelParsed()) );
+        d_progress.setProgressValueAndText( s_progParse, tr("Parsing %1 files").arg(d_parseTotal) );
+    }else
+        finishProgress();
+    ModelManager::instance()->updateFiles( mdl, d_srcFiles + d_libFiles );
+    emit fileListChanged();
+    d_loaded = true;
+}
 
-    fillNode( srcFiles, sourceFolder );
+void Project::onFillNodes()
+{
+    const QString fileName = d_document->filePath().toString();
+    ScopedTimer timer( "Project::onFillNodes", fileName );
+    const QDir base( QFileInfo(fileName).absolutePath() );
+    QStringList& pending = !d_pendingLibs.isEmpty() ? d_pendingLibs : d_pendingSrcs;
+    ProjectExplorer::FolderNode* folder = &pending == &d_pendingLibs ? d_libsFolder : d_sourceFolder;
+    const int n = qMin( s_nodesPerStep, pending.size() );
+    addFileNodes( pending.mid( 0, n ), folder, base );
+    pending.erase( pending.begin(), pending.begin() + n );
+    if( !d_pendingLibs.isEmpty() || !d_pendingSrcs.isEmpty() )
+        d_fillTimer.start();
+}
 
-    d_srcFiles = srcFiles;
+void Project::flushFileNodes()
+{
+    d_fillTimer.stop();
+    const QString fileName = d_document->filePath().toString();
+    const QDir base( QFileInfo(fileName).absolutePath() );
+    if( !d_pendingLibs.isEmpty() )
+        addFileNodes( d_pendingLibs, d_libsFolder, base );
+    if( !d_pendingSrcs.isEmpty() )
+        addFileNodes( d_pendingSrcs, d_sourceFolder, base );
+    d_pendingLibs.clear();
+    d_pendingSrcs.clear();
+}
 
-    mdl->updateFiles( d_srcFiles + d_libFiles );
-    emit fileListChanged();
+void Project::onFileParsed(const QString&)
+{
+    if( d_parsing == 0 || d_parseTotal == 0 )
+        return;
+    d_parsed++;
+    if( d_parsed >= d_parseTotal )
+        d_progress.setProgressValueAndText( s_progResolve, tr("Resolving") );
+    else
+        d_progress.setProgressValue( s_progParse +
+                                     ( s_progResolve - s_progParse ) * qint64(d_parsed) / d_parseTotal );
+}
 
-    QDir::setCurrent(oldCur);
+void Project::onModelParsed()
+{
+    finishProgress();
 }
 
-static void filterFiles( QStringList& in, QSet<QString>& out, QSet<QString>& filter )
+void Project::resolveIncDirs(const QDir& base)
 {
-    if( filter.isEmpty() )
-    {
-        // Trivialfall
-        foreach( const QString& s, in )
-            out.insert(s);
-    }else
-    {
-        foreach( const QString& s, in )
-        {
-            if( !filter.contains( QFileInfo(s).fileName() ) )
-                out.insert(s);
-        }
-    }
-    in.clear();
-    filter.clear();
+    d_incDirs = ProjectLoader::resolveIncDirs( base, d_config );
 }
 
-void Project::findFilesInDirs(const QStringList& dirs, const QStringList& filter, QSet<QString>& files)
+void Project::addFileNodes(const QStringList& files, ProjectExplorer::FolderNode* root, const QDir& base)
 {
-    int i = 0;
-    QStringList files2;
-    QSet<QString> filter2;
-    while( i < dirs.size() )
+    // Nodes are added with one call per folder, each call notifies the project tree;
+    // sub folders are named by the path relative to the project directory
+    QHash<QString,ProjectExplorer::FolderNode*> folders;
+    foreach( ProjectExplorer::FolderNode* f, root->subFolderNodes() )
+        folders.insert( f->path().toString(), f );
+    const QList<ProjectLoader::Folder> groups = ProjectLoader::groupByFolder( base, files );
+    QList<ProjectExplorer::FolderNode*> newFolders;
+    QList<ProjectExplorer::FolderNode*> order;
+    foreach( const ProjectLoader::Folder& g, groups )
     {
-        QString dir = dirs[i];
-        if( dir.startsWith('-') )
-        {
-            // Element ist eine auszulassende Datei
-            filter2.insert( dir.mid(1).trimmed() );
-        }else
+        ProjectExplorer::FolderNode* cur = root;
+        if( !g.d_name.isEmpty() )
         {
-            if( !files2.isEmpty() )
-                filterFiles( files2, files, filter2 );
-            // Element ist ein zu durchsuchendes Verzeichnis
-            bool recursive = false;
-            if( dir.endsWith( '*' ) )
+            cur = folders.value(g.d_name);
+            if( cur == 0 )
             {
-                recursive = true;
-                dir.chop(1);
+                cur = new ProjectExplorer::FolderNode(Utils::FileName::fromString( g.d_name ) );
+                newFolders << cur;
+                folders.insert( g.d_name, cur );
             }
-            findFilesInDir(dir,filter,files2,recursive);
         }
-        i++;
+        order << cur;
+    }
+    if( !newFolders.isEmpty() )
+        root->addFolderNodes( newFolders );
+    for( int i = 0; i < groups.size(); i++ )
+    {
+        QList<ProjectExplorer::FileNode*> nodes;
+        foreach( const QString& file, groups[i].d_files )
+            nodes << new ProjectExplorer::FileNode(Utils::FileName::fromString(file),
+                                                   ProjectExplorer::SourceType, false);
+        order[i]->addFileNodes( nodes );
     }
-    if( !files2.isEmpty() )
-        filterFiles( files2, files, filter2 );
 }
 
-void Project::findFilesInDir(const QString& dirPath, const QStringList& filter, QStringList& out, bool recursive )
+static QSet<QString> toSet(const QStringList& l)
 {
-    QStringList files;
-
-    QDir dir(dirPath);
+#if QT_VERSION >= QT_VERSION_CHECK(5, 14, 0)
+    return QSet<QString>(l.begin(), l.end());
+#else
+    return l.toSet();
+#endif
+}
 
-    if( recursive )
+void Project::removeFileNodes(const QStringList& files, ProjectExplorer::FolderNode* root)
+{
+    const QSet<QString> toRemove = toSet(files);
+    QList<ProjectExplorer::FolderNode*> folders = root->subFolderNodes();
+    folders.prepend(root);
+    QList<ProjectExplorer::FolderNode*> emptied;
+    foreach( ProjectExplorer::FolderNode* folder, folders )
     {
-        files = dir.entryList( QDir::Dirs | QDir::NoDotAndDotDot );
-
-        foreach( const QString& f, files )
+        QList<ProjectExplorer::FileNode*> nodes;
+        foreach( ProjectExplorer::FileNode* n, folder->fileNodes() )
         {
-            findFilesInDir( dir.absoluteFilePath(f), filter, out, recursive );
+            if( toRemove.contains( n->path().toString() ) )
+                nodes << n;
         }
+        if( nodes.isEmpty() )
+            continue;
+        const bool empty = nodes.size() == folder->fileNodes().size();
+        folder->removeFileNodes( nodes );
+        if( empty && folder != root )
+            emptied << folder;
     }
-
-    if( !filter.isEmpty() )
-        files = dir.entryList( filter, QDir::Files );
-    else
-        files.clear();
-    for( int i = 0; i < files.size(); i++ )
-    {
-        out.append( dir.absoluteFilePath(files[i]) );
-    }
+    if( !emptied.isEmpty() )
+        root->removeFolderNodes( emptied );
 }
 
-void Project::fillNode(const QStringList& files, ProjectExplorer::FolderNode* root)
+void Project::watchDirs(const QStringList& dirs)
 {
-    int i = 0;
-    QString path;
-    ProjectExplorer::FolderNode* cur = root;
-    while( i < files.size() )
-    {
-        QFileInfo info(files[i]);
-        if( info.path() != path )
-        {
-            path = info.path();
-            if( info.dir() == QDir::current() )
-                cur = root;
-            else
-            {
-                cur = new ProjectExplorer::FolderNode(Utils::FileName::fromString( QDir::current().relativeFilePath(path) ) );
-                root->addFolderNodes(QList<ProjectExplorer::FolderNode*>() << cur );
-
-            }
-        }
-        cur->addFileNodes(QList<ProjectExplorer::FileNode*>() <<
-                     new ProjectExplorer::FileNode(Utils::FileName::fromString(files[i]),
-                                                                    ProjectExplorer::SourceType, false));
-        i++;
-    }
+    const QSet<QString> now = toSet(dirs);
+    const QSet<QString> before = toSet(d_watchedDirs);
+    const QStringList gone = ( before - now ).values();
+    if( !gone.isEmpty() )
+        d_watcher.removePaths( gone );
+    const QStringList fresh = ( now - before ).values();
+    if( !fresh.isEmpty() )
+        d_watcher.addPaths( fresh );
+    d_watchedDirs = dirs;
 }
 
 ProjectExplorer::Project::RestoreResult Project::fromMap(const QVariantMap &map, QString *errorMessage)
@@ -452,6 +555,87 @@ void Project::onFileChanged(const QString& path)
     }
 }
 
+void Project::onDirChanged(const QString& path)
+{
+    // the mtime check of the scanner cache misses changes within the same mtime tick
+    DirScanner::invalidate( QStringList() << path );
+    d_rescanTimer.start();
+}
+
+ProjectLoader::Result Project::rescan(const QString& fileName, const QMap<QString, QStringList>& config)
+{
+    // Runs on a worker thread and only depends on its arguments
+    ScopedTimer timer( "Project::rescan", fileName );
+    ProjectLoader::Result res;
+    res.d_ok = true;
+    res.d_config = config;
+    ProjectLoader::collectFiles( QFileInfo(fileName).absoluteDir(), config,
+                                 res.d_libFiles, res.d_srcFiles, res.d_dirs );
+    return res;
+}
+
+void Project::onRescan()
+{
+    // Only the file set of the watched directories changed; the project file is not evaluated again
+    if( d_libsFolder == 0 || d_sourceFolder == 0 || d_evalWatcher.isRunning() )
+        return; // a running load discovers the files anyway
+    if( d_rescanWatcher.isRunning() )
+    {
+        d_rescanTimer.start(); // the running scan might have missed the latest change
+        return;
+    }
+    d_rescanWatcher.setFuture( QtConcurrent::run( &Project::rescan, d_document->filePath().toString(),
+                                                  d_config ) );
+}
+
+void Project::onRescanned()
+{
+    const ProjectLoader::Result res = d_rescanWatcher.result();
+    if( d_evalWatcher.isRunning() || res.d_config != d_config )
+        return; // the project was loaded again meanwhile
+    flushFileNodes();
+    watchDirs( res.d_dirs );
+    applyFileDelta( QFileInfo(d_document->filePath().toString()).absoluteDir(),
+                    res.d_libFiles, res.d_srcFiles );
+}
+
+void Project::applyFileDelta(const QDir& base, const QStringList& libFiles, const QStringList& srcFiles)
+{
+    const QString fileName = d_document->filePath().toString();
+    ModelManager* mm = ModelManager::instance();
+    CrossRefModel* mdl = mm->getModelForFile(fileName);
+
+    const QSet<QString> oldLibs = toSet(d_libFiles);
+    const QSet<QString> newLibs = toSet(libFiles);
+    const QSet<QString> oldSrcs = toSet(d_srcFiles);
+    const QSet<QString> newSrcs = toSet(srcFiles);
+    const QStringList addedLibs = ( newLibs - oldLibs ).values();
+    const QStringList removedLibs = ( oldLibs - newLibs ).values();
+    const QStringList addedSrcs = ( newSrcs - oldSrcs ).values();
+    const QStringList removedSrcs = ( oldSrcs - newSrcs ).values();
+
+    if( addedLibs.isEmpty() && removedLibs.isEmpty() && addedSrcs.isEmpty() && removedSrcs.isEmpty() )
+        return;
+
+    removeFileNodes( removedLibs, d_libsFolder );
+    addFileNodes( addedLibs, d_libsFolder, base );
+    removeFileNodes( removedSrcs, d_sourceFolder );
+    addFileNodes( addedSrcs, d_sourceFolder, base );
+    d_libFiles = libFiles;
+    d_srcFiles = srcFiles;
+
+    mm->setFootprint( mdl, d_srcFiles + d_libFiles );
+
+    // a file moving between sources and libraries stays in the model
+    const QSet<QString> before = oldLibs + oldSrcs;
+    const QSet<QString> after = newLibs + newSrcs;
+    mm->dropFiles( mdl, ( before - after ).values() );
+    const QStringList added = ( after - before ).values();
+    if( !added.isEmpty() )
+        mm->updateFiles( mdl, added );
+    emit fileListChanged();
+}
+
 ProjectManager::ProjectManager()
 {
 
@@ -24,6 +24,11 @@
 #include <projectexplorer/iprojectmanager.h>
 
 #include <QFileSystemWatcher>
+#include <QTimer>
+#include <QDir>
+#include <QFutureWatcher>
+#include <QFutureInterface>
+#include "LlProjectLoader.h"
 
 namespace TextEditor { class TextDocument; }
 namespace ProjectExplorer { class FolderNode; }
@@ -32,6 +37,7 @@ namespace Ll
 {
     class ProjectManager;
     class ProjectNode;
+    class CrossRefModel;
 
     class Project : public ProjectExplorer::Project
     {
@@ -40,6 +46,7 @@ namespace Ll
         static const char* ID;
 
         explicit Project(ProjectManager *projectManager, const QString &fileName);
+        ~Project();
 
         const QStringList& getSrcFiles() const { return d_srcFiles; }
         const QStringList& getLibFiles() const { return d_libFiles; }
@@ -56,22 +63,54 @@ namespace Ll
         QStringList files(FilesMode) const Q_DECL_OVERRIDE;
     protected:
         void populateDir( const QDir&, ProjectExplorer::FolderNode* );
-        void loadProject( const QString& fileName );
-        static void findFilesInDirs( const QStringList& dirs, const QStringList& filter, QSet<QString>& files );
-        static void findFilesInDir(const QString& dir, const QStringList& filter, QStringList& files , bool recursive);
-        static void fillNode( const QStringList& files, ProjectExplorer::FolderNode* );
+        static ProjectLoader::Result evaluate( QFutureInterface<void> progress, const QString& fileName );
+        static ProjectLoader::Result rescan( const QString& fileName, const QMap<QString, QStringList>& config );
+        void loadProject( const QString& fileName, bool force = false );
+        void applyProject( const QString& fileName, const ProjectLoader::Result&, bool force );
+        void resolveIncDirs( const QDir& base );
+        void applyFileDelta( const QDir& base, const QStringList& libFiles, const QStringList& srcFiles );
+        static void addFileNodes( const QStringList& files, ProjectExplorer::FolderNode*, const QDir& base );
+        static void removeFileNodes( const QStringList& files, ProjectExplorer::FolderNode* );
+        void watchDirs( const QStringList& dirs );
+        void startProgress();
+        void finishProgress();
+        void flushFileNodes();
 
         RestoreResult fromMap(const QVariantMap &map, QString *errorMessage) Q_DECL_OVERRIDE;
     protected slots:
         void onFileChanged(const QString& path);
+        void onDirChanged(const QString& path);
+        void onRescan();
+        void onRescanned();
+        void onEvaluated();
+        void onLoadCanceled();
+        void onFillNodes();
+        void onFileParsed(const QString&);
+        void onModelParsed();
     private:
         ProjectManager* d_projectManager;
         TextEditor::TextDocument* d_document;
         ProjectNode* d_root;
+        ProjectExplorer::FolderNode* d_libsFolder;
+        ProjectExplorer::FolderNode* d_sourceFolder;
         QString d_name;
         QStringList d_srcFiles, d_libFiles, d_incDirs;
         QMap<QString, QStringList> d_config;
+        QStringList d_defines; // sorted DEFINES of the last full load
         QFileSystemWatcher d_watcher;
+        QStringList d_watchedDirs; // resolved SRCDIRS and LIBDIRS
+        QTimer d_rescanTimer;
+        QFutureWatcher<ProjectLoader::Result> d_evalWatcher; // evaluation and file discovery run here
+        QFutureWatcher<ProjectLoader::Result> d_rescanWatcher; // file discovery after directory changes
+        QFutureInterface<void> d_progress; // the load as shown by the progress manager
+        QFutureWatcher<void> d_progressWatcher;
+        QTimer d_fillTimer;
+        QStringList d_pendingLibs, d_pendingSrcs; // not yet in the tree
+        CrossRefModel* d_parsing; // counting the parsed files of this model
+        int d_parsed, d_parseTotal;
+        bool d_evalForce; // the running evaluation is a forced reload
+        bool d_evalPending; // another load was requested while evaluating
+        bool d_loaded;
     };
 
     class ProjectManager : public ProjectExplorer::IProjectManager
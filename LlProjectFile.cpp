@@ -24,11 +24,16 @@
 #include <qfile.h>
 #include <qfileinfo.h>
 #include <qdir.h>
-#include <qregexp.h>
+#include <qregularexpression.h>
+#include <qcache.h>
 #include <qtextstream.h>
 #include <qstack.h>
 #include <qhash.h>
+#include <qset.h>
+#include <qdiriterator.h>
+#include <qprocess.h>
 #include <qdebug.h>
+#include <qmutex.h>
 #ifdef Q_OS_UNIX
 #include <unistd.h>
 #include <sys/utsname.h>
@@ -37,6 +42,7 @@
 #endif
 #include <stdio.h>
 #include <stdlib.h>
+#include <algorithm>
 
 #ifdef Q_OS_WIN32
 #define QT_POPEN _popen
@@ -81,7 +87,9 @@ void warn_msg(QMakeWarn t, const char *fmt, ...)
     }
     fprintf(stderr, "\n");
 }
-static QString  s_pwd;
+// The working directory is per evaluating thread and never changes the process CWD, so that
+// project files can be evaluated on worker threads; relative paths go through qmake_abspath
+static thread_local QString s_pwd;
 static QString qmake_getpwd()
 {
     if(s_pwd.isNull())
@@ -90,12 +98,19 @@ static QString qmake_getpwd()
 }
 static bool qmake_setpwd(const QString& p)
 {
-    if(QDir::setCurrent(p)) {
-        s_pwd = QDir::currentPath();
+    const QString dir = QDir::cleanPath(QDir(qmake_getpwd()).absoluteFilePath(p));
+    if(QFileInfo(dir).isDir()) {
+        s_pwd = dir;
         return true;
     }
     return false;
 }
+static QString qmake_abspath(const QString& file)
+{
+    if(file.isEmpty() || !QDir::isRelativePath(file))
+        return file;
+    return QDir::cleanPath(QDir(qmake_getpwd()).absoluteFilePath(file));
+}
 static QString fixPathToLocalOS( const QString& str )
 {
     return str; // TODO
@@ -105,6 +120,109 @@ static QString fixEnvVariables( const QString& str )
     return str; // TODO
 }
 
+//compiled regular expressions, shared by all evaluation functions
+enum RegexKind { RegexPlain, RegexExact, RegexWildcard, RegexCaseInsensitive, RegexPathGlob };
+enum { RegexCacheSize = 256 };
+static QMutex regex_cache_lock;
+static bool regex_cache_enabled = true;
+
+static inline bool has_wildcard(const QString &w)
+{
+    for(int i = 0; i < w.size(); ++i) {
+        const ushort c = w.at(i).unicode();
+        if(c == '*' || c == '?' || c == '[')
+            return true;
+    }
+    return false;
+}
+
+// same syntax as QRegExp::Wildcard: * ? and [...] sets; in path mode * and ? don't match /
+// and a ** segment matches any number of directories
+static QString wildcard_to_regex(const QString &w, bool path = false)
+{
+    QString rx;
+    rx.reserve(w.size() * 2);
+    for(int i = 0; i < w.size(); ++i) {
+        const QChar c = w.at(i);
+        if(path && c == QLatin1Char('*') && w.midRef(i, 3) == QLatin1String("**/") &&
+                (i == 0 || w.at(i-1) == QLatin1Char('/'))) {
+            rx += QLatin1String("(?:[^/]+/)*");
+            i += 2;
+        } else if(path && c == QLatin1Char('*') && w.midRef(i) == QLatin1String("**") &&
+                  (i == 0 || w.at(i-1) == QLatin1Char('/'))) {
+            rx += QLatin1String(".*");
+            i += 1;
+        } else if(c == QLatin1Char('*')) {
+            rx += path ? QLatin1String("[^/]*") : QLatin1String(".*");
+        } else if(c == QLatin1Char('?')) {
+            rx += path ? QLatin1String("[^/]") : QLatin1String(".");
+        } else if(c == QLatin1Char('[')) {
+            const int close = w.indexOf(QLatin1Char(']'), i + 2);
+            if(close == -1) {
+                rx += QLatin1String("\\[");
+                continue;
+            }
+            QString set = w.mid(i + 1, close - i - 1);
+            if(set.startsWith(QLatin1Char('!')))
+                set[0] = QLatin1Char('^');
+            set.replace(QLatin1Char('\\'), QLatin1String("\\\\"));
+            rx += QLatin1Char('[') + set + QLatin1Char(']');
+            i = close;
+        } else {
+            rx += QRegularExpression::escape(QString(c));
+        }
+    }
+    return rx;
+}
+
+static QRegularExpression cached_regex(const QString &pattern, RegexKind kind = RegexPlain)
+{
+    static QCache<QString, QRegularExpression> cache(RegexCacheSize);
+    const QString key = QString::number(kind) + QLatin1Char(':') + pattern;
+    QMutexLocker lock(&regex_cache_lock);
+    const bool use_cache = regex_cache_enabled;
+    if(!use_cache)
+        lock.unlock();
+    else if(QRegularExpression *re = cache.object(key))
+        return *re;
+    QString rx = pattern;
+    QRegularExpression::PatternOptions opts = QRegularExpression::NoPatternOption;
+    switch(kind) {
+    case RegexExact:
+        rx = QLatin1String("\\A(?:") + pattern + QLatin1String(")\\z");
+        break;
+    case RegexWildcard:
+        rx = QLatin1String("\\A(?:") + wildcard_to_regex(pattern) + QLatin1String(")\\z");
+        break;
+    case RegexCaseInsensitive:
+        opts |= QRegularExpression::CaseInsensitiveOption;
+        break;
+    case RegexPathGlob:
+        rx = QLatin1String("\\A(?:") + wildcard_to_regex(pattern, true) + QLatin1String(")\\z");
+        break;
+    default:
+        break;
+    }
+    if(!use_cache)
+        return QRegularExpression(rx, opts); // compiled on first use, like a local regex
+    QRegularExpression *re = new QRegularExpression(rx, opts);
+    re->optimize();
+    const QRegularExpression res = *re;
+    cache.insert(key, re);
+    return res;
+}
+
+void ProjectFile::setRegexCacheEnabled(bool on)
+{
+    QMutexLocker lock(&regex_cache_lock);
+    regex_cache_enabled = on;
+}
+
+static inline bool regex_matches(const QRegularExpression &re, const QString &str)
+{
+    return re.match(str).hasMatch();
+}
+
 
 //expand fucntions
 enum ExpandFunc { E_MEMBER=1, E_FIRST, E_LAST, E_CAT, E_FROMFILE, E_EVAL, E_LIST,
@@ -114,6 +232,8 @@ enum ExpandFunc { E_MEMBER=1, E_FIRST, E_LAST, E_CAT, E_FROMFILE, E_EVAL, E_LIST
 QMap<QString, ExpandFunc> qmake_expandFunctions()
 {
     static QMap<QString, ExpandFunc> *qmake_expand_functions = 0;
+    static QMutex lock;
+    QMutexLocker guard(&lock);
     if(!qmake_expand_functions) {
         qmake_expand_functions = new QMap<QString, ExpandFunc>;
         // TODO qmakeAddCacheClear(qmakeDeleteCacheClear_QMapStringInt, (void**)&qmake_expand_functions);
@@ -153,6 +273,8 @@ enum TestFunc { T_REQUIRES=1, T_GREATERTHAN, T_LESSTHAN, T_EQUALS,
 QMap<QString, TestFunc> qmake_testFunctions()
 {
     static QMap<QString, TestFunc> *qmake_test_functions = 0;
+    static QMutex lock;
+    QMutexLocker guard(&lock);
     if(!qmake_test_functions) {
         qmake_test_functions = new QMap<QString, TestFunc>;
         qmake_test_functions->insert("requires", T_REQUIRES);
@@ -191,7 +313,8 @@ struct parser_info {
     QString file;
     int line_no;
     bool from_file;
-} parser;
+};
+static thread_local parser_info parser;
 
 static QString remove_quotes(const QString &arg)
 {
@@ -308,6 +431,186 @@ static QStringList split_value_list(const QString &vals, bool do_semicolon=false
     return ret;
 }
 
+// values without anything split_value_list or doVariableReplaceExpand would interpret
+static bool is_plain_value_list(const QString &vals)
+{
+    const QChar *v = vals.unicode();
+    for(int i = 0; i < vals.size(); ++i) {
+        switch(v[i].unicode()) {
+        case '$':
+        case '"':
+        case '\'':
+        case '(':
+        case ')':
+        case '\\':
+        case '\t':
+            return false;
+        default:
+            break;
+        }
+    }
+    return true;
+}
+
+//$$files() support
+struct GlobCache {
+    struct Entry {
+        QString name;
+        bool isDir;
+    };
+    QHash<QString, QList<Entry> > listings; // absolute dir -> entries sorted like QDir
+    QHash<QString, QStringList> results; // pwd, pattern and mode -> files
+
+    static bool lessThan(const Entry &a, const Entry &b)
+    { return a.name.compare(b.name, Qt::CaseInsensitive) < 0; }
+
+    // each directory is read at most once per evaluation
+    const QList<Entry> &list(const QString &dir) {
+        QHash<QString, QList<Entry> >::iterator it = listings.find(dir);
+        if(it != listings.end())
+            return it.value();
+        QList<Entry> &l = listings[dir];
+        QDirIterator dit(dir, QDir::AllEntries | QDir::NoDotAndDotDot);
+        while(dit.hasNext()) {
+            dit.next();
+            Entry e;
+            e.name = dit.fileName();
+            e.isDir = dit.fileInfo().isDir();
+            l.append(e);
+        }
+        std::sort(l.begin(), l.end(), lessThan);
+        return l;
+    }
+};
+
+GlobCache *ProjectFile::globCache()
+{
+    if(!globs) {
+        globs = new GlobCache;
+        ownGlobs = true;
+    }
+    return globs;
+}
+
+static inline QString glob_absolute(const QString &dir)
+{
+    return QDir::cleanPath(QDir(qmake_getpwd()).absoluteFilePath(dir));
+}
+
+static QStringList glob_files(GlobCache &cache, const QString &pattern, bool recursive)
+{
+    const QString key = qmake_getpwd() + QLatin1Char('|') + pattern + QLatin1Char('|') +
+            QLatin1Char(recursive ? '1' : '0');
+    QHash<QString, QStringList>::const_iterator hit = cache.results.find(key);
+    if(hit != cache.results.end())
+        return hit.value();
+
+    QStringList ret;
+    const int globstar = pattern.indexOf(QLatin1String("**"));
+    if(globstar == -1) {
+        // dir/pattern, where pattern matches the names in dir and optionally all subdirectories
+        QStringList dirs;
+        QString r = pattern;
+        const int slash = qMax(r.lastIndexOf(QLatin1Char('/')), r.lastIndexOf(QDir::separator()));
+        if(slash != -1) {
+            dirs.append(r.left(slash));
+            r = r.mid(slash+1);
+        } else {
+            dirs.append("");
+        }
+        const QRegularExpression regex = cached_regex(r, RegexWildcard);
+        for(int d = 0; d < dirs.count(); d++) {
+            QString dir = dirs[d];
+            if(!dir.isEmpty() && !dir.endsWith(dir_sep) && !dir.endsWith(QLatin1Char('/')))
+                dir += "/";
+            const QList<GlobCache::Entry> &l = cache.list(glob_absolute(dir));
+            for(int i = 0; i < l.size(); ++i) {
+                const QString fname = dir + l[i].name;
+                if(l[i].isDir && recursive)
+                    dirs.append(fname);
+                if(regex_matches(regex, l[i].name))
+                    ret += fname;
+            }
+        }
+    } else {
+        // root/**/rest, where rest is matched against the path relative to root
+        const int slash = pattern.lastIndexOf(QLatin1Char('/'), globstar);
+        const QString root = slash == -1 ? QString() : pattern.left(slash + 1);
+        const QRegularExpression regex = cached_regex(pattern.mid(root.size()), RegexPathGlob);
+        QStringList rels;
+        rels.append(QString());
+        QSet<QString> visited;
+        for(int d = 0; d < rels.count(); d++) {
+            const QString abs = glob_absolute(root + rels[d]);
+            const QString canon = QFileInfo(abs).canonicalFilePath();
+            if(canon.isEmpty() || visited.contains(canon))
+                continue; // symlink loop
+            visited.insert(canon);
+            const QList<GlobCache::Entry> &l = cache.list(abs);
+            for(int i = 0; i < l.size(); ++i) {
+                const QString rel = rels[d] + l[i].name;
+                if(l[i].isDir)
+                    rels.append(rel + QLatin1Char('/'));
+                if(regex_matches(regex, rel))
+                    ret += root + rel;
+            }
+        }
+    }
+    cache.results.insert(key, ret);
+    return ret;
+}
+
+//system() support; the output is cached by command line and working directory
+struct SystemResult {
+    QByteArray output;
+    int exitCode;
+    QDateTime when;
+    SystemResult() : exitCode(-1) { }
+};
+static QMutex system_cache_lock;
+static QHash<QString, SystemResult> system_cache;
+static int system_cache_lifetime = 0; // seconds, 0 disables the cache
+
+static SystemResult run_system(const QString &cmd)
+{
+    const QString pwd = qmake_getpwd();
+    const QString key = pwd + QLatin1Char('|') + cmd;
+    {
+        QMutexLocker lock(&system_cache_lock);
+        QHash<QString, SystemResult>::const_iterator it = system_cache.find(key);
+        if(it != system_cache.end() && system_cache_lifetime > 0 &&
+                it.value().when.secsTo(QDateTime::currentDateTime()) < system_cache_lifetime)
+            return it.value();
+    }
+    SystemResult res;
+    QProcess proc;
+    proc.setWorkingDirectory(pwd);
+    proc.setProcessChannelMode(QProcess::ForwardedErrorChannel);
+#ifdef Q_OS_WIN32
+    proc.start(QLatin1String("cmd.exe"), QStringList() << QLatin1String("/c") << cmd);
+#else
+    proc.start(QLatin1String("/bin/sh"), QStringList() << QLatin1String("-c") << cmd);
+#endif
+    if(proc.waitForStarted(-1) && proc.waitForFinished(-1)) {
+        res.output = proc.readAllStandardOutput();
+        if(proc.exitStatus() == QProcess::NormalExit)
+            res.exitCode = proc.exitCode();
+    }
+    res.when = QDateTime::currentDateTime();
+    QMutexLocker lock(&system_cache_lock);
+    if(system_cache_lifetime > 0)
+        system_cache.insert(key, res);
+    return res;
+}
+
+void ProjectFile::setSystemCacheLifetime(int secs)
+{
+    QMutexLocker lock(&system_cache_lock);
+    system_cache_lifetime = qMax(0, secs);
+    if(system_cache_lifetime == 0)
+        system_cache.clear();
+}
+
 //just a parsable entity
 struct ParsableBlock
 {
@@ -501,6 +804,8 @@ public:
 
 ProjectFile::~ProjectFile()
 {
+    if(ownGlobs)
+        delete globs;
     for(QMap<QString, FunctionBlock*>::iterator it = replaceFunctions.begin(); it != replaceFunctions.end(); ++it) {
         if(!it.value()->deref())
             delete it.value();
@@ -519,12 +824,15 @@ ProjectFile::init(const QMap<QString, QStringList> * v)
 {
     if(v)
         vars = *v;
+    globs = 0;
+    ownGlobs = false;
     reset();
 }
 
 ProjectFile::ProjectFile(ProjectFile *p, const QMap<QString, QStringList> *vars)
 {
     init( vars ? vars : &p->variables());
+    globs = p->globCache();
     for(QMap<QString, FunctionBlock*>::iterator it = p->replaceFunctions.begin(); it != p->replaceFunctions.end(); ++it) {
         it.value()->ref();
         replaceFunctions.insert(it.key(), it.value());
@@ -906,7 +1214,10 @@ ProjectFile::parse(const QString &t, QMap<QString, QStringList> &place, int numL
     SKIP_WS(d, d_off, s.length());
     for(; d_off < s.length() && op.indexOf('=') == -1; op += *(d+(d_off++)))
         ;
-    op.replace(QRegExp("\\s"), "");
+    for(int i = op.size() - 1; i >= 0; --i) {
+        if(op.at(i).isSpace())
+            op.remove(i, 1);
+    }
 
     SKIP_WS(d, d_off, s.length());
     QString vals = s.mid(d_off); // vals now contains the space separated list of values
@@ -934,6 +1245,23 @@ ProjectFile::parse(const QString &t, QMap<QString, QStringList> &place, int numL
 
     QStringList &varlist = place[var]; // varlist is the list in the symbol table
 
+    // fast path for the plain file lists of generated project files, e.g. SRCFILES += a.Lola b.Lola;
+    // no expansion, quoting or escaping is possible, so the values go straight into the symbol table
+    if(op == "+=" && var != "REQUIRES" && var != "DEPENDPATH" && var != "INCLUDEPATH" &&
+            is_plain_value_list(vals)) {
+        const QChar *v = vals.unicode();
+        const int len = vals.size();
+        int start = 0;
+        for(int i = 0; i <= len; ++i) {
+            if(i == len || v[i] == QLatin1Char(field_sep)) {
+                if(i > start)
+                    varlist.append(QString(v + start, i - start));
+                start = i + 1;
+            }
+        }
+        return true;
+    }
+
 
     // now do the operation
     if(op == "~=") {
@@ -958,8 +1286,8 @@ ProjectFile::parse(const QString &t, QMap<QString, QStringList> &place, int numL
         }
         QString from = func[1], to = func[2];
         if(quote)
-            from = QRegExp::escape(from);
-        QRegExp regexp(from, case_sense ? Qt::CaseSensitive : Qt::CaseInsensitive);
+            from = QRegularExpression::escape(from);
+        const QRegularExpression regexp = cached_regex(from, case_sense ? RegexPlain : RegexCaseInsensitive);
         for(QStringList::Iterator varit = varlist.begin(); varit != varlist.end();) {
             if((*varit).contains(regexp)) {
                 (*varit) = (*varit).replace(regexp, to);
@@ -1074,9 +1402,10 @@ ProjectFile::read(const QString &file, QMap<QString, QStringList> &place)
         qfile.setFileName("");
         ret = qfile.open(stdin, QIODevice::ReadOnly);
         using_stdin = true;
-    } else if(QFileInfo(file).isDir()) {
+    } else if(QFileInfo(qmake_abspath(filename)).isDir()) {
         return false;
     } else {
+        filename = qmake_abspath(filename);
         qfile.setFileName(filename);
         ret = qfile.open(QIODevice::ReadOnly);
         qmake_setpwd(QFileInfo(filename).absolutePath());
@@ -1113,10 +1442,12 @@ ProjectFile::isActiveConfig(const QString &x, bool regex, QMap<QString, QStringL
         return false;
 
     //simple matching
-    QRegExp re(x, Qt::CaseSensitive, QRegExp::Wildcard);
     const QStringList &configs = (place ? (*place)["CONFIG"] : vars["CONFIG"]);
+    if(!regex || !has_wildcard(x))
+        return configs.contains(x);
+    const QRegularExpression re = cached_regex(x, RegexWildcard);
     for(QStringList::ConstIterator it = configs.begin(); it != configs.end(); ++it) {
-        if(((regex && re.exactMatch((*it))) || (!regex && (*it) == x)) && re.exactMatch((*it)))
+        if(regex_matches(re, *it))
             return true;
     }
     return false;
@@ -1157,6 +1488,146 @@ ProjectFile::doProjectTest(QString func, const QString &params,
     return doProjectTest(func, split_arg_list(params), place);
 }
 
+//include() cache
+struct IncludeDep {
+    QString file;
+    QDateTime modified;
+    qint64 size;
+};
+static inline IncludeDep include_dep(const QString &file)
+{
+    QFileInfo info(file);
+    IncludeDep dep;
+    dep.file = file;
+    dep.modified = info.lastModified();
+    dep.size = info.size();
+    return dep;
+}
+struct IncludeCacheEntry {
+    QMap<QString, QStringList> in, out;
+    QList<IncludeDep> deps; // the file itself and everything it included
+};
+// collects the dependencies of the includes currently being evaluated
+struct IncludeRecorder {
+    QList<IncludeDep> deps;
+    bool is_volatile;
+    IncludeRecorder() : is_volatile(false) { }
+};
+static QMutex include_cache_lock;
+static QHash<QString, QList<IncludeCacheEntry> > include_cache;
+static int include_cache_hits = 0, include_cache_misses = 0;
+static thread_local QList<IncludeRecorder*> include_recorders;
+enum { MaxIncludeCacheVariants = 4 };
+
+static inline bool include_is_word_char(char c)
+{
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+}
+
+// results of these functions and of $$_DATE_ depend on more than the file contents and the
+// incoming variables; functions only count when called, i.e. as "name(" or "$$name("
+static bool include_is_volatile(const QString &file)
+{
+    static const char* volatile_funcs[] = { "system", "prompt", "files", "exists",
+                                             "cat", "fromfile", "infile", "export", 0 };
+    QFile qfile(file);
+    if(!qfile.open(QIODevice::ReadOnly))
+        return true;
+    const QByteArray text = qfile.readAll();
+    const int n = text.size();
+    int i = 0;
+    while(i < n) {
+        if(!include_is_word_char(text[i])) {
+            ++i;
+            continue;
+        }
+        const int start = i;
+        while(i < n && include_is_word_char(text[i]))
+            ++i;
+        const QByteArray word = QByteArray::fromRawData(text.constData() + start, i - start);
+        if(word == "_DATE_")
+            return true;
+        int j = i;
+        while(j < n && (text[j] == ' ' || text[j] == '\t'))
+            ++j;
+        if(j == n || text[j] != '(')
+            continue;
+        for(int f = 0; volatile_funcs[f]; ++f) {
+            if(word == volatile_funcs[f])
+                return true;
+        }
+    }
+    return false;
+}
+
+static void include_record(const QList<IncludeDep> &deps, bool is_volatile)
+{
+    for(int i = 0; i < include_recorders.size(); ++i) {
+        include_recorders[i]->deps += deps;
+        if(is_volatile)
+            include_recorders[i]->is_volatile = true;
+    }
+}
+
+static bool include_cache_lookup(const QString &key, QMap<QString, QStringList> &place)
+{
+    QMutexLocker lock(&include_cache_lock);
+    QHash<QString, QList<IncludeCacheEntry> >::iterator it = include_cache.find(key);
+    if(it != include_cache.end()) {
+        QList<IncludeCacheEntry> &entries = it.value();
+        for(int i = 0; i < entries.size(); ++i) {
+            const IncludeCacheEntry &e = entries.at(i);
+            bool valid = true;
+            for(int j = 0; j < e.deps.size() && valid; ++j) {
+                const IncludeDep now = include_dep(e.deps[j].file);
+                valid = now.modified == e.deps[j].modified && now.size == e.deps[j].size;
+            }
+            if(!valid) {
+                entries.removeAt(i--);
+                continue;
+            }
+            if(e.in != place)
+                continue;
+            place = e.out;
+            include_record(e.deps, false);
+            if(i != 0)
+                entries.move(i, 0);
+            include_cache_hits++;
+            return true;
+        }
+    }
+    include_cache_misses++;
+    return false;
+}
+
+static void include_cache_insert(const QString &key, const QMap<QString, QStringList> &in,
+                                 const QMap<QString, QStringList> &out, const QList<IncludeDep> &deps)
+{
+    QMutexLocker lock(&include_cache_lock);
+    IncludeCacheEntry e;
+    e.in = in;
+    e.out = out;
+    e.deps = deps;
+    QList<IncludeCacheEntry> &entries = include_cache[key];
+    entries.prepend(e);
+    while(entries.size() > MaxIncludeCacheVariants)
+        entries.removeLast();
+}
+
+void ProjectFile::includeCacheStatistics(int &hits, int &misses)
+{
+    QMutexLocker lock(&include_cache_lock);
+    hits = include_cache_hits;
+    misses = include_cache_misses;
+}
+
+void ProjectFile::clearIncludeCache()
+{
+    QMutexLocker lock(&include_cache_lock);
+    include_cache.clear();
+    include_cache_hits = include_cache_misses = 0;
+}
+
 ProjectFile::IncludeStatus
 ProjectFile::doProjectInclude(QString file, uchar flags, QMap<QString, QStringList> &place)
 {
@@ -1176,6 +1647,8 @@ ProjectFile::doProjectInclude(QString file, uchar flags, QMap<QString, QStringLi
             }
         }
     }
+    if(QDir::isRelativePath(file))
+        file = QDir::toNativeSeparators(qmake_abspath(file));
     if(format == UnknownFormat) {
         if(QFile::exists(file)) {
             format = ProFormat;
@@ -1187,11 +1660,26 @@ ProjectFile::doProjectInclude(QString file, uchar flags, QMap<QString, QStringLi
               file.toLatin1().constData());
 
     QString orig_file = file;
+
+    // Functions defined by the includer are not part of the key, neither are the function
+    // blocks an export() could modify
+    const QString cache_key = QFileInfo(orig_file).absoluteFilePath() + QLatin1Char('|') + QString::number(flags);
+    const bool cacheable = format == ProFormat && testFunctions.isEmpty() && replaceFunctions.isEmpty() &&
+            function_blocks.isEmpty();
+    if(cacheable && include_cache_lookup(cache_key, place))
+        return IncludeSuccess;
+    const QMap<QString, QStringList> incoming = cacheable ? place : QMap<QString, QStringList>();
+    IncludeRecorder recorder;
+    recorder.deps.append(include_dep(QFileInfo(orig_file).absoluteFilePath()));
+    recorder.is_volatile = include_is_volatile(orig_file);
+    include_recorders.append(&recorder);
+
     int di = file.lastIndexOf(QDir::separator());
     QString oldpwd = qmake_getpwd();
     if(di != -1) {
         if(!qmake_setpwd(file.left(file.lastIndexOf(QDir::separator())))) {
             fprintf(stderr, "Cannot find directory: %s\n", file.left(di).toLatin1().constData());
+            include_recorders.removeAll(&recorder);
             return IncludeFailure;
         }
         file = file.right(file.length() - di - 1);
@@ -1235,6 +1723,13 @@ ProjectFile::doProjectInclude(QString file, uchar flags, QMap<QString, QStringLi
     }
     parser = pi;
     qmake_setpwd(oldpwd);
+
+    include_recorders.removeAll(&recorder);
+    include_record(recorder.deps, recorder.is_volatile);
+    if(parsed && cacheable && !recorder.is_volatile &&
+            testFunctions.isEmpty() && replaceFunctions.isEmpty())
+        include_cache_insert(cache_key, incoming, place, recorder.deps);
+
     if(!parsed)
         return IncludeParseFailure;
     return IncludeSuccess;
@@ -1363,7 +1858,7 @@ ProjectFile::doProjectExpand(QString func, QList<QStringList> args_list,
             if(args.count() > 1)
                 singleLine = (args[1].toLower() == "true");
 
-            QFile qfile(file);
+            QFile qfile(qmake_abspath(file));
             if(qfile.open(QIODevice::ReadOnly)) {
                 QTextStream stream(&qfile);
                 while(!stream.atEnd()) {
@@ -1418,9 +1913,9 @@ ProjectFile::doProjectExpand(QString func, QList<QStringList> args_list,
         }
         break; }
     case E_LIST: {
-        static int x = 0;
+        static QAtomicInt x;
         QString tmp;
-        tmp.sprintf(".QMAKE_INTERNAL_TMP_VAR_%d", x++);
+        tmp.sprintf(".QMAKE_INTERNAL_TMP_VAR_%d", x.fetchAndAddRelaxed(1));
         ret = QStringList(tmp);
         QStringList &lst = (*((QMap<QString, QStringList>*)&place))[tmp];
         lst.clear();
@@ -1496,7 +1991,7 @@ ProjectFile::doProjectExpand(QString func, QList<QStringList> args_list,
             } else {
                 var = args[0];
                 regexp = true;
-                sep = "[" + QRegExp::escape(dir_sep) + "/]";
+                sep = "[" + QRegularExpression::escape(dir_sep) + "/]";
                 if(func_t == E_DIRNAME)
                     end = -2;
                 else
@@ -1505,12 +2000,12 @@ ProjectFile::doProjectExpand(QString func, QList<QStringList> args_list,
         }
         if(!var.isNull()) {
             const QStringList &l = values(var, place);
+            const QRegularExpression separator = regexp ? cached_regex(sep) : QRegularExpression();
             for(QStringList::ConstIterator it = l.begin(); it != l.end(); ++it) {
-                QString separator = sep;
                 if(regexp)
-                    ret += (*it).section(QRegExp(separator), beg, end);
-                else
                     ret += (*it).section(separator, beg, end);
+                else
+                    ret += (*it).section(sep, beg, end);
             }
         }
         break; }
@@ -1519,11 +2014,11 @@ ProjectFile::doProjectExpand(QString func, QList<QStringList> args_list,
             fprintf(stderr, "%s:%d find(var, str) requires two arguments\n",
                     parser.file.toLatin1().constData(), parser.line_no);
         } else {
-            QRegExp regx(args[1]);
+            const QRegularExpression regx = cached_regex(args[1]);
             const QStringList &var = values(args.first(), place);
             for(QStringList::ConstIterator vit = var.begin();
                 vit != var.end(); ++vit) {
-                if(regx.indexIn(*vit) != -1)
+                if(regex_matches(regx, *vit))
                     ret += (*vit);
             }
         }
@@ -1534,24 +2029,15 @@ ProjectFile::doProjectExpand(QString func, QList<QStringList> args_list,
                     parser.file.toLatin1().constData(), parser.line_no);
         } else {
             QMakeProjectEnv env(place);
-            char buff[256];
-            FILE *proc = QT_POPEN(args[0].toLatin1(), "r");
             bool singleLine = true;
             if(args.count() > 1)
                 singleLine = (args[1].toLower() == "true");
-            QString output;
-            while(proc && !feof(proc)) {
-                int read_in = int(fread(buff, 1, 255, proc));
-                if(!read_in)
-                    break;
-                for(int i = 0; i < read_in; i++) {
-                    if((singleLine && buff[i] == '\n') || buff[i] == '\t')
-                        buff[i] = ' ';
-                }
-                buff[read_in] = '\0';
-                output += buff;
+            QByteArray buff = run_system(args[0]).output;
+            for(int i = 0; i < buff.size(); i++) {
+                if((singleLine && buff[i] == '\n') || buff[i] == '\t')
+                    buff[i] = ' ';
             }
-            ret += split_value_list(output);
+            ret += split_value_list(QString::fromLocal8Bit(buff));
         }
         break; }
     case E_UNIQUE: {
@@ -1603,7 +2089,7 @@ ProjectFile::doProjectExpand(QString func, QList<QStringList> args_list,
         break; }
     case E_RE_ESCAPE: {
         for(int i = 0; i < args.size(); ++i)
-            ret += QRegExp::escape(args[i]);
+            ret += QRegularExpression::escape(args[i]);
         break; }
     case E_UPPER:
     case E_LOWER: {
@@ -1622,35 +2108,7 @@ ProjectFile::doProjectExpand(QString func, QList<QStringList> args_list,
             bool recursive = false;
             if(args.count() == 2)
                 recursive = (args[1].toLower() == "true" || args[1].toInt());
-            QStringList dirs;
-            QString r = fixPathToLocalOS(args[0]);
-            int slash = r.lastIndexOf(QDir::separator());
-            if(slash != -1) {
-                dirs.append(r.left(slash));
-                r = r.mid(slash+1);
-            } else {
-                dirs.append("");
-            }
-
-            const QRegExp regex(r, Qt::CaseSensitive, QRegExp::Wildcard);
-            for(int d = 0; d < dirs.count(); d++) {
-                QString dir = dirs[d];
-                if(!dir.isEmpty() && !dir.endsWith(dir_sep))
-                    dir += "/";
-
-                QDir qdir(dir);
-                for(int i = 0; i < (int)qdir.count(); ++i) {
-                    if(qdir[i] == "." || qdir[i] == "..")
-                        continue;
-                    QString fname = dir + qdir[i];
-                    if(QFileInfo(fname).isDir()) {
-                        if(recursive)
-                            dirs.append(fname);
-                    }
-                    if(regex.exactMatch(qdir[i]))
-                        ret += fname;
-                }
-            }
+            ret = glob_files(*globCache(), fixPathToLocalOS(args[0]), recursive);
         }
         break; }
     case E_PROMPT: {
@@ -1679,7 +2137,7 @@ ProjectFile::doProjectExpand(QString func, QList<QStringList> args_list,
             fprintf(stderr, "%s:%d replace(var, before, after) requires three arguments\n",
                     parser.file.toLatin1().constData(), parser.line_no);
         } else {
-            const QRegExp before( args[1] );
+            const QRegularExpression before = cached_regex( args[1] );
             const QString after( args[2] );
             QStringList var = values(args.first(), place);
             for(QStringList::Iterator it = var.begin(); it != var.end(); ++it)
@@ -1833,13 +2291,13 @@ ProjectFile::doProjectTest(QString func, QList<QStringList> args_list, QMap<QStr
         QString file = args.first();
         file = fixPathToLocalOS(file);
 
-        if(QFile::exists(file))
+        if(QFile::exists(qmake_abspath(file)))
             return true;
         //regular expression I guess
         QString dirstr = qmake_getpwd();
         int slsh = file.lastIndexOf(dir_sep);
         if(slsh != -1) {
-            dirstr = file.left(slsh+1);
+            dirstr = qmake_abspath(file.left(slsh+1));
             file = file.right(file.length() - slsh - 1);
         }
         return QDir(dirstr).entryList(QStringList(file)).count(); }
@@ -1922,7 +2380,7 @@ ProjectFile::doProjectTest(QString func, QList<QStringList> args_list, QMap<QStr
         QMakeProjectEnv env;
         if(setup_env)
             env.execute(place);
-        bool ret = system(args[0].toLatin1().constData()) == 0;
+        bool ret = run_system(args[0]).exitCode == 0;
         return ret; }
     case T_RETURN:
         if(function_blocks.isEmpty()) {
@@ -1976,12 +2434,12 @@ ProjectFile::doProjectTest(QString func, QList<QStringList> args_list, QMap<QStr
                     parser.file.toLatin1().constData(), parser.line_no);
             return false;
         }
-        QRegExp regx(args[1]);
+        const QRegularExpression regx = cached_regex(args[1], RegexExact);
         const QStringList &l = values(args[0], place);
         if(args.count() == 2) {
             for(int i = 0; i < l.size(); ++i) {
                 const QString val = l[i];
-                if(regx.exactMatch(val) || val == args[1])
+                if(val == args[1] || regex_matches(regx, val))
                     return true;
             }
         } else {
@@ -1990,7 +2448,7 @@ ProjectFile::doProjectTest(QString func, QList<QStringList> args_list, QMap<QStr
                 const QString val = l[i];
                 for(int mut = 0; mut < mutuals.count(); mut++) {
                     if(val == mutuals[mut].trimmed())
-                        return (regx.exactMatch(val) || val == args[1]);
+                        return (val == args[1] || regex_matches(regx, val));
                 }
             }
         }
@@ -2016,10 +2474,10 @@ ProjectFile::doProjectTest(QString func, QList<QStringList> args_list, QMap<QStr
             if(args.count() == 2) {
                 ret = tmp.contains(args[1]);
             } else {
-                QRegExp regx(args[2]);
+                const QRegularExpression regx = cached_regex(args[2], RegexExact);
                 const QStringList &l = tmp[args[1]];
                 for(QStringList::ConstIterator it = l.begin(); it != l.end(); ++it) {
-                    if(regx.exactMatch((*it)) || (*it) == args[2]) {
+                    if((*it) == args[2] || regex_matches(regx, *it)) {
                         ret = true;
                         break;
                     }
@@ -32,6 +32,7 @@ namespace Ll
 struct ParsableBlock;
 struct IteratorBlock;
 struct FunctionBlock;
+struct GlobCache;
 
 class ProjectFile
 {
@@ -54,6 +55,9 @@ class ProjectFile
     IteratorBlock *iterator;
     FunctionBlock *function;
     QMap<QString, FunctionBlock*> testFunctions, replaceFunctions;
+    GlobCache *globs; // directory listings and $$files() results of this evaluation
+    bool ownGlobs;
+    GlobCache *globCache();
 
     QString pfile;
     void reset();
@@ -90,6 +94,14 @@ public:
     inline bool parse(const QString &text) { return parse(text, vars); }
     inline bool read(const QString &file) { pfile = file; return read(file, vars); }
 
+    // include() results are cached by file, mtime and incoming variables across all instances
+    static void includeCacheStatistics(int &hits, int &misses);
+    static void clearIncludeCache();
+    // system() output is reused for the same command line and directory within this lifetime
+    static void setSystemCacheLifetime(int secs);
+    // compiled regular expressions are shared across calls unless disabled; for benchmarks
+    static void setRegexCacheEnabled(bool);
+
     QStringList userExpandFunctions() { return replaceFunctions.keys(); }
     QStringList userTestFunctions() { return testFunctions.keys(); }
 
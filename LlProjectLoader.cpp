@@ -0,0 +1,212 @@
+/*
+* Copyright 2019 Rochus Keller <mailto:me@rochus-keller.ch>
+*
+* This file is part of the LolaCreator plugin.
+*
+* The following is the license that applies to this copy of the
+* plugin. For a license to use the plugin under conditions
+* other than those described here, please email to me@rochus-keller.ch.
+*
+* GNU General Public License Usage
+* This file may be used under the terms of the GNU General Public
+* License (GPL) versions 2.0 or 3.0 as published by the Free Software
+* Foundation and appearing in the file LICENSE.GPL included in
+* the packaging of this file. Please review the following information
+* to ensure GNU General Public Licensing requirements will be met:
+* http://www.fsf.org/licensing/licenses/info/GPLv2.html and
+* http://www.gnu.org/copyleft/gpl.html.
+*/
+
+#include "LlProjectLoader.h"
+#include "LlProjectFile.h"
+#include "LlDirScanner.h"
+#include <QFileInfo>
+#include <QHash>
+using namespace Ll;
+
+ProjectLoader::Result ProjectLoader::load(const QString& fileName)
+{
+    Result res = evaluate( fileName );
+    if( res.d_ok )
+        discover( fileName, res );
+    return res;
+}
+
+ProjectLoader::Result ProjectLoader::evaluate(const QString& fileName)
+{
+    Result res;
+    res.d_config["SRCEXT"] << ".Lola"; // Preset
+    res.d_config["LIBEXT"] << ".Lola";
+
+    ProjectFile p( res.d_config );
+    res.d_ok = p.read(fileName);
+    if( res.d_ok )
+        res.d_config = p.variables();
+    //qDebug() << res.d_config; // TEST
+    return res;
+}
+
+void ProjectLoader::discover(const QString& fileName, ProjectLoader::Result& res)
+{
+    // relative paths are resolved against the project directory, not the process CWD
+    const QDir base( QFileInfo(fileName).absolutePath() );
+    collectFiles( base, res.d_config, res.d_libFiles, res.d_srcFiles, res.d_dirs );
+}
+
+QStringList ProjectLoader::resolveIncDirs(const QDir& base, const QMap<QString, QStringList>& config)
+{
+    QStringList res;
+    const QStringList incDirs = config.value("INCDIRS");
+    foreach( const QString& d, incDirs )
+    {
+        QFileInfo info(d);
+        QString path;
+        if( info.isRelative() )
+            path = QDir::cleanPath( base.absoluteFilePath(d) );
+        else
+            path = info.canonicalPath();
+        if( !res.contains(path) )
+        {
+            res.append(path);
+        }
+    }
+    return res;
+}
+
+static void filterFiles( QStringList& in, QSet<QString>& out, QSet<QString>& filter )
+{
+    if( filter.isEmpty() )
+    {
+        // Trivialfall
+        foreach( const QString& s, in )
+            out.insert(s);
+    }else
+    {
+        foreach( const QString& s, in )
+        {
+            if( !filter.contains( QFileInfo(s).fileName() ) )
+                out.insert(s);
+        }
+    }
+    in.clear();
+    filter.clear();
+}
+
+void ProjectLoader::collectFiles(const QDir& base, const QMap<QString, QStringList>& config,
+                           QStringList& libFiles, QStringList& srcFiles, QStringList& dirs)
+{
+    QSet<QString> files;
+
+    findFilesInDirs( base, config.value("LIBDIRS"), config.value("LIBEXT"), files, &dirs );
+    addListedFiles( base, config.value("LIBFILES"), config.value("LIBEXT"), files );
+    libFiles = files.toList();
+    libFiles.sort();
+
+    files.clear();
+    srcFiles = config.value("SRCFILES");
+    QStringList srcDirs = config.value("SRCDIRS");
+    if( srcFiles.isEmpty() && ( srcDirs.isEmpty() || srcDirs.first().startsWith('-') ) )
+        srcDirs.prepend(".*");
+
+    findFilesInDirs( base, srcDirs, config.value("SRCEXT"), files, &dirs );
+    addListedFiles( base, srcFiles, config.value("SRCEXT"), files );
+    srcFiles = files.toList();
+    srcFiles.sort();
+}
+
+void ProjectLoader::findFilesInDirs(const QDir& base, const QStringList& dirs, const QStringList& suffixes,
+                              QSet<QString>& files, QStringList* visited)
+{
+    int i = 0;
+    QStringList files2;
+    QSet<QString> filter2;
+    while( i < dirs.size() )
+    {
+        QString dir = dirs[i];
+        if( dir.startsWith('-') )
+        {
+            // Element ist eine auszulassende Datei
+            filter2.insert( dir.mid(1).trimmed() );
+        }else
+        {
+            if( !files2.isEmpty() )
+                filterFiles( files2, files, filter2 );
+            // Element ist ein zu durchsuchendes Verzeichnis
+            bool recursive = false;
+            if( dir.endsWith( '*' ) )
+            {
+                recursive = true;
+                dir.chop(1);
+            }
+            DirScanner::findFiles( base, dir, suffixes, files2, recursive, visited );
+        }
+        i++;
+    }
+    if( !files2.isEmpty() )
+        filterFiles( files2, files, filter2 );
+}
+
+void ProjectLoader::addListedFiles(const QDir& base, const QStringList& list, const QStringList& suffixes,
+                             QSet<QString>& files)
+{
+    files.reserve( files.size() + list.size() );
+    // a directory entry sets the directory for the relative file entries following it
+    QDir lastDir = base;
+    foreach( const QString& f, list )
+    {
+        const bool relative = QDir::isRelativePath(f);
+        // entries with a source suffix are taken as files without asking the file system
+        bool isFile = false;
+        foreach( const QString& suffix, suffixes )
+        {
+            if( f.endsWith( suffix, Qt::CaseInsensitive ) )
+            {
+                isFile = true;
+                break;
+            }
+        }
+        if( !isFile && QFileInfo( relative ? base.absoluteFilePath(f) : f ).isDir() )
+        {
+            if( relative )
+                lastDir = QDir( base.absoluteFilePath(f) );
+            else
+                lastDir = QFileInfo(f).absoluteDir();
+        }else
+        {
+            if( relative )
+                files.insert( QDir::cleanPath( lastDir.absoluteFilePath(f) ) );
+            else
+                files.insert(f);
+        }
+    }
+}
+
+QList<ProjectLoader::Folder> ProjectLoader::groupByFolder(const QDir& base, const QStringList& files)
+{
+    // the files are usually sorted, so the directory only changes between runs
+    const QString basePath = base.absolutePath();
+    QList<Folder> res;
+    QHash<QString,int> index; // directory -> position in res
+    QString lastPath;
+    int cur = -1;
+    foreach( const QString& file, files )
+    {
+        const int slash = file.lastIndexOf(QLatin1Char('/'));
+        const QString path = slash > 0 ? file.left(slash) : QString(QLatin1Char('/'));
+        if( path != lastPath || cur == -1 )
+        {
+            lastPath = path;
+            cur = index.value( path, -1 );
+            if( cur == -1 )
+            {
+                cur = res.size();
+                index.insert( path, cur );
+                res.append( Folder() );
+                if( path != basePath )
+                    res.last().d_name = base.relativeFilePath( path );
+            }
+        }
+        res[cur].d_files.append( file );
+    }
+    return res;
+}
@@ -0,0 +1,68 @@
+#ifndef LLPROJECTLOADER_H
+#define LLPROJECTLOADER_H
+
+/*
+* Copyright 2019 Rochus Keller <mailto:me@rochus-keller.ch>
+*
+* This file is part of the LolaCreator plugin.
+*
+* The following is the license that applies to this copy of the
+* plugin. For a license to use the plugin under conditions
+* other than those described here, please email to me@rochus-keller.ch.
+*
+* GNU General Public License Usage
+* This file may be used under the terms of the GNU General Public
+* License (GPL) versions 2.0 or 3.0 as published by the Free Software
+* Foundation and appearing in the file LICENSE.GPL included in
+* the packaging of this file. Please review the following information
+* to ensure GNU General Public Licensing requirements will be met:
+* http://www.fsf.org/licensing/licenses/info/GPLv2.html and
+* http://www.gnu.org/copyleft/gpl.html.
+*/
+
+#include <QDir>
+#include <QMap>
+#include <QSet>
+#include <QStringList>
+
+namespace Ll
+{
+    // Evaluates an llpro file and discovers its source and library files. Depends on QtCore
+    // only, so it is shared by the plugin and the lolaindex command line tool.
+    class ProjectLoader
+    {
+    public:
+        struct Result
+        {
+            bool d_ok;
+            QMap<QString, QStringList> d_config;
+            QStringList d_libFiles, d_srcFiles, d_dirs; // sorted; d_dirs are the scanned directories
+            Result():d_ok(false) {}
+        };
+        struct Folder
+        {
+            QString d_name; // relative to the project directory, empty for the directory itself
+            QStringList d_files;
+        };
+
+        // All functions are thread safe. load() is evaluate() followed by discover().
+        static Result load( const QString& fileName );
+        static Result evaluate( const QString& fileName );
+        static void discover( const QString& fileName, Result& );
+
+        static QStringList resolveIncDirs( const QDir& base, const QMap<QString, QStringList>& config );
+        static void collectFiles( const QDir& base, const QMap<QString, QStringList>& config,
+                                  QStringList& libFiles, QStringList& srcFiles, QStringList& dirs );
+        static void findFilesInDirs( const QDir& base, const QStringList& dirs, const QStringList& suffixes,
+                                     QSet<QString>& files, QStringList* visited = 0 );
+        static void addListedFiles( const QDir& base, const QStringList& list, const QStringList& suffixes,
+                                    QSet<QString>& files );
+        // Groups files by their directory in the order of first appearance, so that a project
+        // tree can be filled with one call per folder
+        static QList<Folder> groupByFolder( const QDir& base, const QStringList& files );
+    private:
+        ProjectLoader() {}
+    };
+}
+
+#endif // LLPROJECTLOADER_H
@@ -0,0 +1,326 @@
+/*
+* Copyright 2019 Rochus Keller <mailto:me@rochus-keller.ch>
+*
+* This file is part of the LolaCreator plugin.
+*
+* The following is the license that applies to this copy of the
+* plugin. For a license to use the plugin under conditions
+* other than those described here, please email to me@rochus-keller.ch.
+*
+* GNU General Public License Usage
+* This file may be used under the terms of the GNU General Public
+* License (GPL) versions 2.0 or 3.0 as published by the Free Software
+* Foundation and appearing in the file LICENSE.GPL included in
+* the packaging of this file. Please review the following information
+* to ensure GNU General Public Licensing requirements will be met:
+* http://www.fsf.org/licensing/licenses/info/GPLv2.html and
+* http://www.gnu.org/copyleft/gpl.html.
+*/
+
+#include "LlScanKernels.h"
+using namespace Ll;
+
+#if defined(__SSE2__) || defined(_M_X64) || ( defined(_M_IX86_FP) && _M_IX86_FP >= 2 )
+#define LL_SSE2
+#include <emmintrin.h>
+#if defined(_MSC_VER)
+#define LL_AVX2
+#define LL_TARGET_AVX2
+#include <immintrin.h>
+#include <intrin.h>
+#elif defined(__clang__) || ( defined(__GNUC__) && ( __GNUC__ > 4 || ( __GNUC__ == 4 && __GNUC_MINOR__ >= 9 ) ) )
+// only the AVX2 functions are compiled for AVX2, the rest of the build stays at the baseline
+#define LL_AVX2
+#define LL_TARGET_AVX2 __attribute__((target("avx2")))
+#include <immintrin.h>
+#endif
+#endif
+
+namespace
+{
+    inline bool isWhitespace( ushort c )
+    {
+        return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+    }
+
+    inline bool isIdentChar( ushort c )
+    {
+        return ( c >= 'a' && c <= 'z' ) || ( c >= 'A' && c <= 'Z' ) || ( c >= '0' && c <= '9' ) || c == '_';
+    }
+
+    inline bool isHexDigit( ushort c )
+    {
+        return ( c >= '0' && c <= '9' ) || ( c >= 'A' && c <= 'F' ) || ( c >= 'a' && c <= 'f' );
+    }
+
+    int whitespaceScalar( const ushort* str, int pos, int len )
+    {
+        while( pos < len && isWhitespace( str[pos] ) )
+            pos++;
+        return pos;
+    }
+
+    int identScalar( const ushort* str, int pos, int len )
+    {
+        while( pos < len && isIdentChar( str[pos] ) )
+            pos++;
+        return pos;
+    }
+
+    int hexScalar( const ushort* str, int pos, int len )
+    {
+        while( pos < len && isHexDigit( str[pos] ) )
+            pos++;
+        return pos;
+    }
+
+    int pairScalar( const ushort* str, int pos, int len, ushort first, ushort second )
+    {
+        for( ; pos + 1 < len; pos++ )
+        {
+            if( str[pos] == first && str[pos+1] == second )
+                return pos;
+        }
+        return -1;
+    }
+
+#ifdef LL_SSE2
+    // index of the lowest set bit; the movemask of 16 bit lanes has two bits per character
+    inline int lowestBit( quint32 mask )
+    {
+#ifdef _MSC_VER
+        unsigned long i;
+        _BitScanForward( &i, mask );
+        return int(i);
+#else
+        return __builtin_ctz( mask );
+#endif
+    }
+
+    // Characters from 0x8000 are negative in the signed compares; they are in none of the
+    // ASCII classes anyway.
+    inline __m128i inRange( __m128i v, short lo, short hi )
+    {
+        return _mm_and_si128( _mm_cmpgt_epi16( v, _mm_set1_epi16( lo - 1 ) ),
+                              _mm_cmplt_epi16( v, _mm_set1_epi16( hi + 1 ) ) );
+    }
+
+    int whitespaceSse2( const ushort* str, int pos, int len )
+    {
+        const __m128i sp = _mm_set1_epi16(' ');
+        const __m128i tab = _mm_set1_epi16('\t');
+        const __m128i cr = _mm_set1_epi16('\r');
+        const __m128i lf = _mm_set1_epi16('\n');
+        for( ; pos + 8 <= len; pos += 8 )
+        {
+            const __m128i v = _mm_loadu_si128( reinterpret_cast<const __m128i*>( str + pos ) );
+            const __m128i m = _mm_or_si128( _mm_or_si128( _mm_cmpeq_epi16( v, sp ), _mm_cmpeq_epi16( v, tab ) ),
+                                            _mm_or_si128( _mm_cmpeq_epi16( v, cr ), _mm_cmpeq_epi16( v, lf ) ) );
+            const quint32 miss = ~quint32( _mm_movemask_epi8( m ) ) & 0xffff;
+            if( miss )
+                return pos + lowestBit( miss ) / 2;
+        }
+        return whitespaceScalar( str, pos, len );
+    }
+
+    int identSse2( const ushort* str, int pos, int len )
+    {
+        const __m128i lower = _mm_set1_epi16(0x20);
+        const __m128i us = _mm_set1_epi16('_');
+        for( ; pos + 8 <= len; pos += 8 )
+        {
+            const __m128i v = _mm_loadu_si128( reinterpret_cast<const __m128i*>( str + pos ) );
+            const __m128i m = _mm_or_si128( _mm_or_si128( inRange( _mm_or_si128( v, lower ), 'a', 'z' ),
+                                                          inRange( v, '0', '9' ) ), _mm_cmpeq_epi16( v, us ) );
+            const quint32 miss = ~quint32( _mm_movemask_epi8( m ) ) & 0xffff;
+            if( miss )
+                return pos + lowestBit( miss ) / 2;
+        }
+        return identScalar( str, pos, len );
+    }
+
+    int hexSse2( const ushort* str, int pos, int len )
+    {
+        const __m128i lower = _mm_set1_epi16(0x20);
+        for( ; pos + 8 <= len; pos += 8 )
+        {
+            const __m128i v = _mm_loadu_si128( reinterpret_cast<const __m128i*>( str + pos ) );
+            const __m128i m = _mm_or_si128( inRange( _mm_or_si128( v, lower ), 'a', 'f' ), inRange( v, '0', '9' ) );
+            const quint32 miss = ~quint32( _mm_movemask_epi8( m ) ) & 0xffff;
+            if( miss )
+                return pos + lowestBit( miss ) / 2;
+        }
+        return hexScalar( str, pos, len );
+    }
+
+    int pairSse2( const ushort* str, int pos, int len, ushort first, ushort second )
+    {
+        const __m128i a = _mm_set1_epi16( short(first) );
+        const __m128i b = _mm_set1_epi16( short(second) );
+        // the second load is one character ahead, so nine characters must be left
+        for( ; pos + 9 <= len; pos += 8 )
+        {
+            const __m128i v0 = _mm_loadu_si128( reinterpret_cast<const __m128i*>( str + pos ) );
+            const __m128i v1 = _mm_loadu_si128( reinterpret_cast<const __m128i*>( str + pos + 1 ) );
+            const quint32 hit = _mm_movemask_epi8( _mm_and_si128( _mm_cmpeq_epi16( v0, a ), _mm_cmpeq_epi16( v1, b ) ) );
+            if( hit )
+                return pos + lowestBit( hit ) / 2;
+        }
+        return pairScalar( str, pos, len, first, second );
+    }
+#endif // LL_SSE2
+
+#ifdef LL_AVX2
+    LL_TARGET_AVX2 inline __m256i inRange256( __m256i v, short lo, short hi )
+    {
+        return _mm256_and_si256( _mm256_cmpgt_epi16( v, _mm256_set1_epi16( lo - 1 ) ),
+                                 _mm256_cmpgt_epi16( _mm256_set1_epi16( hi + 1 ), v ) );
+    }
+
+    LL_TARGET_AVX2 int whitespaceAvx2( const ushort* str, int pos, int len )
+    {
+        const __m256i sp = _mm256_set1_epi16(' ');
+        const __m256i tab = _mm256_set1_epi16('\t');
+        const __m256i cr = _mm256_set1_epi16('\r');
+        const __m256i lf = _mm256_set1_epi16('\n');
+        for( ; pos + 16 <= len; pos += 16 )
+        {
+            const __m256i v = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( str + pos ) );
+            const __m256i m = _mm256_or_si256( _mm256_or_si256( _mm256_cmpeq_epi16( v, sp ), _mm256_cmpeq_epi16( v, tab ) ),
+                                               _mm256_or_si256( _mm256_cmpeq_epi16( v, cr ), _mm256_cmpeq_epi16( v, lf ) ) );
+            const quint32 miss = ~quint32( _mm256_movemask_epi8( m ) );
+            if( miss )
+                return pos + lowestBit( miss ) / 2;
+        }
+        return whitespaceSse2( str, pos, len );
+    }
+
+    LL_TARGET_AVX2 int identAvx2( const ushort* str, int pos, int len )
+    {
+        const __m256i lower = _mm256_set1_epi16(0x20);
+        const __m256i us = _mm256_set1_epi16('_');
+        for( ; pos + 16 <= len; pos += 16 )
+        {
+            const __m256i v = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( str + pos ) );
+            const __m256i m = _mm256_or_si256( _mm256_or_si256( inRange256( _mm256_or_si256( v, lower ), 'a', 'z' ),
+                                                                inRange256( v, '0', '9' ) ), _mm256_cmpeq_epi16( v, us ) );
+            const quint32 miss = ~quint32( _mm256_movemask_epi8( m ) );
+            if( miss )
+                return pos + lowestBit( miss ) / 2;
+        }
+        return identSse2( str, pos, len );
+    }
+
+    LL_TARGET_AVX2 int hexAvx2( const ushort* str, int pos, int len )
+    {
+        const __m256i lower = _mm256_set1_epi16(0x20);
+        for( ; pos + 16 <= len; pos += 16 )
+        {
+            const __m256i v = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( str + pos ) );
+            const __m256i m = _mm256_or_si256( inRange256( _mm256_or_si256( v, lower ), 'a', 'f' ), inRange256( v, '0', '9' ) );
+            const quint32 miss = ~quint32( _mm256_movemask_epi8( m ) );
+            if( miss )
+                return pos + lowestBit( miss ) / 2;
+        }
+        return hexSse2( str, pos, len );
+    }
+
+    LL_TARGET_AVX2 int pairAvx2( const ushort* str, int pos, int len, ushort first, ushort second )
+    {
+        const __m256i a = _mm256_set1_epi16( short(first) );
+        const __m256i b = _mm256_set1_epi16( short(second) );
+        for( ; pos + 17 <= len; pos += 16 )
+        {
+            const __m256i v0 = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( str + pos ) );
+            const __m256i v1 = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( str + pos + 1 ) );
+            const quint32 hit = _mm256_movemask_epi8( _mm256_and_si256( _mm256_cmpeq_epi16( v0, a ), _mm256_cmpeq_epi16( v1, b ) ) );
+            if( hit )
+                return pos + lowestBit( hit ) / 2;
+        }
+        return pairSse2( str, pos, len, first, second );
+    }
+
+    bool cpuHasAvx2()
+    {
+#ifdef _MSC_VER
+        int info[4];
+        __cpuid( info, 1 );
+        const bool osxsave = ( info[2] & ( 1 << 27 ) ) != 0;
+        if( !osxsave || ( _xgetbv(0) & 6 ) != 6 ) // the OS saves the YMM registers
+            return false;
+        __cpuidex( info, 7, 0 );
+        return ( info[1] & ( 1 << 5 ) ) != 0;
+#else
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2");
+#endif
+    }
+#endif // LL_AVX2
+
+    ScanKernels::Level detect()
+    {
+#if defined(LL_AVX2)
+        return cpuHasAvx2() ? ScanKernels::AVX2 : ScanKernels::SSE2;
+#elif defined(LL_SSE2)
+        return ScanKernels::SSE2;
+#else
+        return ScanKernels::Scalar;
+#endif
+    }
+}
+
+ScanKernels::Impl ScanKernels::s_impl = { whitespaceScalar, identScalar, hexScalar, pairScalar };
+ScanKernels::Level ScanKernels::s_level = ScanKernels::Scalar;
+
+// picks the best level before main, so that the kernels need no check per call
+static const bool s_init = ( ScanKernels::setLevel( ScanKernels::supported() ), true );
+
+ScanKernels::Level ScanKernels::supported()
+{
+    static const Level l = detect();
+    return l;
+}
+
+void ScanKernels::setLevel(ScanKernels::Level l)
+{
+    l = qMin( l, supported() );
+    switch( l )
+    {
+#ifdef LL_AVX2
+    case AVX2:
+        {
+            const Impl i = { whitespaceAvx2, identAvx2, hexAvx2, pairAvx2 };
+            s_impl = i;
+        }
+        break;
+#endif
+#ifdef LL_SSE2
+    case SSE2:
+        {
+            const Impl i = { whitespaceSse2, identSse2, hexSse2, pairSse2 };
+            s_impl = i;
+        }
+        break;
+#endif
+    default:
+        {
+            const Impl i = { whitespaceScalar, identScalar, hexScalar, pairScalar };
+            s_impl = i;
+        }
+        break;
+    }
+    s_level = l;
+}
+
+const char* ScanKernels::name(ScanKernels::Level l)
+{
+    switch( l )
+    {
+    case SSE2:
+        return "sse2";
+    case AVX2:
+        return "avx2";
+    default:
+        return "scalar";
+    }
+}
@@ -0,0 +1,62 @@
+#ifndef LLSCANKERNELS_H
+#define LLSCANKERNELS_H
+
+/*
+* Copyright 2019 Rochus Keller <mailto:me@rochus-keller.ch>
+*
+* This file is part of the LolaCreator plugin.
+*
+* The following is the license that applies to this copy of the
+* plugin. For a license to use the plugin under conditions
+* other than those described here, please email to me@rochus-keller.ch.
+*
+* GNU General Public License Usage
+* This file may be used under the terms of the GNU General Public
+* License (GPL) versions 2.0 or 3.0 as published by the Free Software
+* Foundation and appearing in the file LICENSE.GPL included in
+* the packaging of this file. Please review the following information
+* to ensure GNU General Public Licensing requirements will be met:
+* http://www.fsf.org/licensing/licenses/info/GPLv2.html and
+* http://www.gnu.org/copyleft/gpl.html.
+*/
+
+#include <QtGlobal>
+
+namespace Ll
+{
+    // The inner loops of the span lexer over UTF-16 text, vectorised with SSE2 or AVX2 when the
+    // CPU has them; the implementation is chosen once at startup, with a scalar fallback.
+    class ScanKernels
+    {
+    public:
+        enum Level { Scalar, SSE2, AVX2 };
+
+        static Level level() { return s_level; }
+        static Level supported(); // the best level of this CPU and build
+        static void setLevel( Level ); // capped at supported(); for benchmarks
+        static const char* name( Level );
+
+        // each returns the position of the first character at or past pos not in the class, or len
+        static int skipWhitespace( const ushort* str, int pos, int len ) { return s_impl.d_whitespace( str, pos, len ); }
+        static int skipIdentChars( const ushort* str, int pos, int len ) { return s_impl.d_ident( str, pos, len ); }
+        static int skipHexDigits( const ushort* str, int pos, int len ) { return s_impl.d_hex( str, pos, len ); }
+
+        // position of the first "*)" at or past pos, or -1
+        static int findCommentEnd( const ushort* str, int pos, int len ) { return s_impl.d_pair( str, pos, len, '*', ')' ); }
+        static int findCommentStart( const ushort* str, int pos, int len ) { return s_impl.d_pair( str, pos, len, '(', '*' ); }
+    private:
+        typedef int (*Skip)( const ushort*, int, int );
+        typedef int (*Pair)( const ushort*, int, int, ushort, ushort );
+        struct Impl
+        {
+            Skip d_whitespace;
+            Skip d_ident;
+            Skip d_hex;
+            Pair d_pair;
+        };
+        static Impl s_impl;
+        static Level s_level;
+    };
+}
+
+#endif // LLSCANKERNELS_H
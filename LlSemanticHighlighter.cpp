@@ -0,0 +1,269 @@
+/*
+* Copyright 2019 Rochus Keller <mailto:me@rochus-keller.ch>
+*
+* This file is part of the LolaCreator plugin.
+*
+* The following is the license that applies to this copy of the
+* plugin. For a license to use the plugin under conditions
+* other than those described here, please email to me@rochus-keller.ch.
+*
+* GNU General Public License Usage
+* This file may be used under the terms of the GNU General Public
+* License (GPL) versions 2.0 or 3.0 as published by the Free Software
+* Foundation and appearing in the file LICENSE.GPL included in
+* the packaging of this file. Please review the following information
+* to ensure GNU General Public Licensing requirements will be met:
+* http://www.fsf.org/licensing/licenses/info/GPLv2.html and
+* http://www.gnu.org/copyleft/gpl.html.
+*/
+
+#include "LlSemanticHighlighter.h"
+#include <Lola/LlCrossRefModel.h>
+#include <Lola/LlLexer.h>
+#include <texteditor/textdocument.h>
+#include <texteditor/syntaxhighlighter.h>
+#include <QtConcurrentRun>
+#include <QTextDocument>
+#include <QTextBlock>
+#include <QHash>
+using namespace Ll;
+
+SemanticHighlighter::SemanticHighlighter(TextEditor::TextDocument* doc):QObject(doc),
+    d_doc(doc),d_revision(-1),d_pending(false)
+{
+    // same palette register as Highlighter1, which leaves all identifiers black
+    d_format[ModuleType].setForeground(QColor(153, 0, 115));
+    d_format[Register].setForeground(QColor(170, 85, 0));
+    d_format[Wire].setForeground(QColor(0, 102, 153));
+    d_format[Input].setForeground(QColor(0, 128, 0));
+    d_format[Output].setForeground(QColor(128, 0, 128));
+    d_format[Constant].setForeground(QColor(0, 153, 153));
+    d_format[Constant].setFontItalic(true);
+
+    connect( &d_watcher, SIGNAL(finished()), this, SLOT(onFinished()) );
+    connect( doc->document(), SIGNAL(contentsChange(int,int,int)), this, SLOT(onContentsChange(int,int,int)) );
+}
+
+static const SemanticHighlighter::Uses& unknown()
+{
+    // never equal to a result, so the line is set again
+    static SemanticHighlighter::Uses u;
+    if( u.isEmpty() )
+    {
+        SemanticHighlighter::Use v = { 0, 0, 0, SemanticHighlighter::MaxKind };
+        u.append(v);
+    }
+    return u;
+}
+
+void SemanticHighlighter::update(CrossRefModel* mdl)
+{
+    d_moduleTypes.clear();
+    if( mdl )
+    {
+        // modules are the only global names which open a scope
+        foreach( const CrossRefModel::IdentDeclRef& id, mdl->getGlobalNames() )
+        {
+            if( id->decl()->toScope() )
+                d_moduleTypes.insert( id->tok().d_val );
+        }
+    }
+    if( d_watcher.isRunning() )
+        d_pending = true; // the running analysis is outdated; restart when it is done
+    else
+        start();
+}
+
+void SemanticHighlighter::start()
+{
+    d_pending = false;
+    d_revision = d_doc->document()->revision();
+    d_watcher.setFuture( QtConcurrent::run( &SemanticHighlighter::analyze, d_doc->plainText(), d_moduleTypes ) );
+}
+
+void SemanticHighlighter::onFinished()
+{
+    if( d_pending )
+    {
+        start();
+        return;
+    }
+    // the result refers to an older text if the user typed meanwhile; the next parse brings a new one
+    if( d_revision != d_doc->document()->revision() )
+        return;
+    const Uses uses = d_watcher.result();
+    d_result = QVector<Uses>( d_doc->document()->blockCount() );
+    foreach( const Use& u, uses )
+    {
+        if( u.d_line > 0 && int(u.d_line) <= d_result.size() )
+            d_result[u.d_line-1].append(u);
+    }
+    d_lines.resize( d_result.size() );
+    emit sigReady();
+}
+
+void SemanticHighlighter::apply(int from, int to)
+{
+    TextEditor::SyntaxHighlighter* hl = d_doc->syntaxHighlighter();
+    if( hl == 0 )
+        return;
+    to = qMin( to, d_result.size() );
+    QTextBlock block = d_doc->document()->findBlockByNumber(from);
+    for( int i = from; i < to && block.isValid(); i++, block = block.next() )
+    {
+        const Uses& now = d_result[i];
+        if( d_lines[i] == now )
+            continue;
+        QList<QTextLayout::FormatRange> ranges;
+        foreach( const Use& u, now )
+        {
+            QTextLayout::FormatRange r;
+            r.start = u.d_col - 1;
+            r.length = u.d_len;
+            r.format = d_format[u.d_kind];
+            ranges.append(r);
+        }
+        // only marks this block dirty, there is no rehighlight of the document
+        hl->setExtraAdditionalFormats( block, ranges );
+        d_lines[i] = now;
+    }
+}
+
+void SemanticHighlighter::onContentsChange(int pos, int removed, int added)
+{
+    Q_UNUSED(removed);
+    Q_UNUSED(added);
+    if( d_lines.isEmpty() )
+        return;
+    // the applied formats move with their blocks, so d_lines follows inserted and removed lines
+    const int n = d_doc->document()->findBlock(pos).blockNumber();
+    if( n < 0 || n >= d_lines.size() )
+        return;
+    const int delta = d_doc->document()->blockCount() - d_lines.size();
+    if( delta < 0 )
+        d_lines.remove( n + 1, qMin( -delta, d_lines.size() - n - 1 ) );
+    else if( delta > 0 )
+        d_lines.insert( n + 1, delta, unknown() );
+    d_lines[n] = unknown();
+    // a result of an older revision no longer matches the blocks
+    if( d_doc->document()->revision() != d_revision )
+        d_result.clear();
+}
+
+static int sectionOf( const Token& t )
+{
+    // the Lola-2 declaration sections; returns -1 for other tokens
+    switch( t.d_type )
+    {
+    case Tok_CONST:
+        return SemanticHighlighter::Constant;
+    case Tok_IN:
+    case Tok_INOUT:
+        return SemanticHighlighter::Input;
+    case Tok_OUT:
+        return SemanticHighlighter::Output;
+    case Tok_REG:
+        return SemanticHighlighter::Register;
+    case Tok_VAR:
+        return SemanticHighlighter::Wire;
+    case Tok_TYPE:
+        return SemanticHighlighter::ModuleType;
+    default:
+        return -1;
+    }
+}
+
+SemanticHighlighter::Uses SemanticHighlighter::analyze(const QString& text, const QSet<QByteArray>& moduleTypes)
+{
+    struct Scope
+    {
+        QByteArray d_name;
+        QHash<QByteArray,quint8> d_names;
+    };
+    QList<Scope> scopes;
+    scopes.append( Scope() );
+
+    Uses res;
+    Lexer lex;
+    const QList<Token> toks = lex.tokens(text);
+
+    int section = -1; // the declaration section we are in
+    int sectionDepth = 0; // parentheses depth of the section keyword; module parameters are in parentheses
+    int depth = 0;
+    bool inIdList = false; // identifiers are declared, not used
+    for( int i = 0; i < toks.size(); i++ )
+    {
+        const Token& t = toks[i];
+        if( t.d_type == Tok_identifier )
+        {
+            Use u;
+            u.d_line = t.d_lineNr;
+            u.d_col = t.d_colNr;
+            u.d_len = t.d_len;
+            if( section != -1 && inIdList && depth == sectionDepth )
+            {
+                scopes.last().d_names.insert( t.d_val, section );
+                u.d_kind = section;
+                res.append(u);
+                continue;
+            }
+            int kind = -1;
+            for( int s = scopes.size() - 1; s >= 0 && kind == -1; s-- )
+                kind = scopes[s].d_names.value( t.d_val, -1 );
+            if( kind == -1 && moduleTypes.contains( t.d_val ) )
+                kind = ModuleType;
+            if( kind != -1 )
+            {
+                u.d_kind = kind;
+                res.append(u);
+            }
+            continue;
+        }
+
+        const int sec = sectionOf(t);
+        if( sec != -1 )
+        {
+            section = sec;
+            sectionDepth = depth;
+            inIdList = true;
+        }else if( t.d_type == Tok_Lpar )
+            depth++;
+        else if( t.d_type == Tok_Rpar )
+        {
+            if( --depth < sectionDepth )
+                section = -1;
+        }else if( t.d_type == Tok_Semi || t.d_type == Tok_Comma )
+            inIdList = true;
+        else if( t.d_type == Tok_Colon || t.d_type == Tok_Eq || t.d_type == Tok_ColonEq )
+            inIdList = false;
+        else if( t.d_type == Tok_BEGIN )
+            section = -1;
+        else if( t.d_type == Tok_MODULE )
+        {
+            // MODULE M declares M in the enclosing scope; TYPE T = MODULE already declared T
+            Scope s;
+            if( i + 1 < toks.size() && toks[i+1].d_type == Tok_identifier )
+            {
+                s.d_name = toks[i+1].d_val;
+                scopes.last().d_names.insert( s.d_name, ModuleType );
+            }else if( i > 1 && toks[i-1].d_type == Tok_Eq && toks[i-2].d_type == Tok_identifier )
+                s.d_name = toks[i-2].d_val;
+            scopes.append(s);
+            section = -1;
+        }else if( t.d_type == Tok_END && i + 1 < toks.size() && toks[i+1].d_type == Tok_identifier )
+        {
+            // END of a statement is not followed by a module name
+            for( int s = scopes.size() - 1; s > 0; s-- )
+            {
+                if( scopes[s].d_name == toks[i+1].d_val )
+                {
+                    while( scopes.size() > s )
+                        scopes.removeLast();
+                    section = -1;
+                    break;
+                }
+            }
+        }
+    }
+    return res;
+}
@@ -0,0 +1,89 @@
+#ifndef LLSEMANTICHIGHLIGHTER_H
+#define LLSEMANTICHIGHLIGHTER_H
+
+/*
+* Copyright 2019 Rochus Keller <mailto:me@rochus-keller.ch>
+*
+* This file is part of the LolaCreator plugin.
+*
+* The following is the license that applies to this copy of the
+* plugin. For a license to use the plugin under conditions
+* other than those described here, please email to me@rochus-keller.ch.
+*
+* GNU General Public License Usage
+* This file may be used under the terms of the GNU General Public
+* License (GPL) versions 2.0 or 3.0 as published by the Free Software
+* Foundation and appearing in the file LICENSE.GPL included in
+* the packaging of this file. Please review the following information
+* to ensure GNU General Public Licensing requirements will be met:
+* http://www.fsf.org/licensing/licenses/info/GPLv2.html and
+* http://www.gnu.org/copyleft/gpl.html.
+*/
+
+#include <QObject>
+#include <QFutureWatcher>
+#include <QTextCharFormat>
+#include <QSet>
+#include <QVector>
+
+namespace TextEditor { class TextDocument; }
+
+namespace Ll
+{
+    class CrossRefModel;
+
+    // Colours identifiers by the kind of their declaration on top of the lexical Highlighter1.
+    // The analysis runs on a worker after each parse of the document; sigReady announces a result,
+    // which apply() sets as extra additional formats, and only on the lines whose result changed.
+    class SemanticHighlighter : public QObject
+    {
+        Q_OBJECT
+    public:
+        enum Kind { ModuleType, Register, Wire, Input, Output, Constant, MaxKind };
+        struct Use
+        {
+            quint32 d_line; // 1-based like Token
+            int d_col; // 1-based
+            int d_len;
+            quint8 d_kind;
+            bool operator==( const Use& rhs ) const { return d_line == rhs.d_line && d_col == rhs.d_col &&
+                        d_len == rhs.d_len && d_kind == rhs.d_kind; }
+        };
+        typedef QVector<Use> Uses; // ordered by position
+
+        explicit SemanticHighlighter( TextEditor::TextDocument* );
+
+        // starts a new analysis of the document; module types declared elsewhere come from mdl
+        void update( CrossRefModel* mdl );
+
+        // applies the latest result to the blocks from..to (exclusive)
+        void apply( int from, int to );
+
+        // thread safe; moduleTypes are names of module types visible from everywhere
+        static Uses analyze( const QString& text, const QSet<QByteArray>& moduleTypes );
+
+    signals:
+        void sigReady();
+
+    protected slots:
+        void onFinished();
+        void onContentsChange( int pos, int removed, int added );
+
+    protected:
+        void start();
+
+    private:
+        TextEditor::TextDocument* d_doc;
+        QFutureWatcher<Uses> d_watcher;
+        QVector<Uses> d_result; // by line - 1
+        QVector<Uses> d_lines; // what is currently applied, by line - 1
+        QSet<QByteArray> d_moduleTypes;
+        QTextCharFormat d_format[MaxKind];
+        int d_revision;
+        bool d_pending;
+    };
+}
+
+Q_DECLARE_TYPEINFO(Ll::SemanticHighlighter::Use, Q_PRIMITIVE_TYPE);
+
+#endif // LLSEMANTICHIGHLIGHTER_H
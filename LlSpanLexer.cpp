@@ -0,0 +1,187 @@
+/*
+* Copyright 2019 Rochus Keller <mailto:me@rochus-keller.ch>
+*
+* This file is part of the LolaCreator plugin.
+*
+* The following is the license that applies to this copy of the
+* plugin. For a license to use the plugin under conditions
+* other than those described here, please email to me@rochus-keller.ch.
+*
+* GNU General Public License Usage
+* This file may be used under the terms of the GNU General Public
+* License (GPL) versions 2.0 or 3.0 as published by the Free Software
+* Foundation and appearing in the file LICENSE.GPL included in
+* the packaging of this file. Please review the following information
+* to ensure GNU General Public Licensing requirements will be met:
+* http://www.fsf.org/licensing/licenses/info/GPLv2.html and
+* http://www.gnu.org/copyleft/gpl.html.
+*/
+
+#include "LlSpanLexer.h"
+#include "LlScanKernels.h"
+#include <Lola/LlLexer.h>
+#include <QHash>
+using namespace Ll;
+
+namespace
+{
+    // Keywords and operators of the Lola token table, keyed by up to eight packed latin1
+    // characters so that a lookup needs no string
+    struct Tables
+    {
+        QHash<quint64,quint8> d_keywords;
+        QHash<quint64,quint8> d_operators;
+        int d_maxOperator;
+
+        static quint64 pack( const char* str, int len )
+        {
+            quint64 k = 0;
+            for( int i = 0; i < len; i++ )
+                k = ( k << 8 ) | quint8( str[i] );
+            return k;
+        }
+
+        Tables():d_maxOperator(1)
+        {
+            for( int i = 1; i < 256; i++ )
+            {
+                const char* str = tokenTypeString(i);
+                const int len = str ? int(::strlen(str)) : 0;
+                if( len == 0 || len > 8 )
+                    continue;
+                if( tokenTypeIsKeyword(i) )
+                    d_keywords.insert( pack( str, len ), i );
+                else if( tokenTypeIsLiteral(i) )
+                {
+                    d_operators.insert( pack( str, len ), i );
+                    d_maxOperator = qMax( d_maxOperator, len );
+                }
+            }
+        }
+    };
+
+    const Tables& tables()
+    {
+        static const Tables t; // thread safe initialisation
+        return t;
+    }
+
+    inline bool isLetter( ushort c )
+    {
+        return ( c >= 'a' && c <= 'z' ) || ( c >= 'A' && c <= 'Z' );
+    }
+
+    inline bool isDigit( ushort c )
+    {
+        return c >= '0' && c <= '9';
+    }
+
+    inline quint64 pack( const QChar* str, int len, bool* ok )
+    {
+        quint64 k = 0;
+        *ok = len <= 8;
+        for( int i = 0; i < len && *ok; i++ )
+        {
+            const ushort c = str[i].unicode();
+            if( c >= 128 )
+                *ok = false;
+            k = ( k << 8 ) | quint8( c );
+        }
+        return k;
+    }
+}
+
+int SpanLexer::scan(const QChar* str, int len, Span* out, int cap, int col)
+{
+    const Tables& tab = tables();
+    const ushort* u = reinterpret_cast<const ushort*>( str );
+    int n = 0;
+    int i = 0;
+    // the spans past cap are only counted
+    auto span = [&]( int type, int start, int length )
+    {
+        if( n < cap )
+        {
+            out[n].d_col = col + start;
+            out[n].d_len = length;
+            out[n].d_type = quint8( type );
+        }
+        n++;
+    };
+
+    while( i < len )
+    {
+        const ushort c = str[i].unicode();
+        if( c == ' ' || c == '\t' || c == '\r' || c == '\n' )
+        {
+            i = ScanKernels::skipWhitespace( u, i + 1, len );
+            continue;
+        }
+        const int start = i;
+        if( c == '(' && i + 1 < len && str[i+1].unicode() == '*' )
+        {
+            span( Tok_Latt, start, 2 );
+            i += 2;
+            int end = ScanKernels::findCommentEnd( u, i, len );
+            const bool closed = end != -1;
+            if( !closed )
+                end = len;
+            if( end > i )
+                span( Tok_Comment, i, end - i );
+            i = end;
+            if( closed )
+            {
+                span( Tok_Ratt, i, 2 );
+                i += 2;
+            }
+            continue;
+        }
+        if( isLetter(c) )
+        {
+            i = ScanKernels::skipIdentChars( u, i + 1, len );
+            bool ok;
+            const quint64 k = pack( str + start, i - start, &ok );
+            const quint8 kw = ok ? tab.d_keywords.value( k, 0 ) : 0;
+            span( kw ? kw : quint8(Tok_identifier), start, i - start );
+            continue;
+        }
+        if( isDigit(c) )
+        {
+            // decimal, hexadecimal with a trailing H, and the 'x width suffix
+            i = ScanKernels::skipHexDigits( u, i, len );
+            if( i < len && ( str[i] == QLatin1Char('H') || str[i] == QLatin1Char('h') ) )
+                i++;
+            if( i < len && str[i] == QLatin1Char('\'') )
+                i = ScanKernels::skipHexDigits( u, i + 1, len );
+            span( Tok_integer, start, i - start );
+            continue;
+        }
+        // the longest operator first
+        int type = 0;
+        for( int l = qMin( tab.d_maxOperator, len - i ); l > 0 && type == 0; l-- )
+        {
+            bool ok;
+            const quint64 k = pack( str + i, l, &ok );
+            if( ok && ( type = tab.d_operators.value( k, 0 ) ) != 0 )
+                i += l;
+        }
+        if( type != 0 )
+            span( type, start, i - start );
+        else
+            i++; // not a Lola-2 character
+    }
+    return n;
+}
+
+int SpanLexer::scan(const QChar* str, int len, QVector<Span>& buf, int col)
+{
+    if( buf.isEmpty() )
+        buf.resize(64);
+    int n = scan( str, len, buf.data(), buf.size(), col );
+    if( n > buf.size() )
+    {
+        buf.resize(n);
+        n = scan( str, len, buf.data(), buf.size(), col );
+    }
+    return n;
+}
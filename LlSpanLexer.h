@@ -0,0 +1,53 @@
+#ifndef LLSPANLEXER_H
+#define LLSPANLEXER_H
+
+/*
+* Copyright 2019 Rochus Keller <mailto:me@rochus-keller.ch>
+*
+* This file is part of the LolaCreator plugin.
+*
+* The following is the license that applies to this copy of the
+* plugin. For a license to use the plugin under conditions
+* other than those described here, please email to me@rochus-keller.ch.
+*
+* GNU General Public License Usage
+* This file may be used under the terms of the GNU General Public
+* License (GPL) versions 2.0 or 3.0 as published by the Free Software
+* Foundation and appearing in the file LICENSE.GPL included in
+* the packaging of this file. Please review the following information
+* to ensure GNU General Public Licensing requirements will be met:
+* http://www.fsf.org/licensing/licenses/info/GPLv2.html and
+* http://www.gnu.org/copyleft/gpl.html.
+*/
+
+#include <QChar>
+#include <QVector>
+
+namespace Ll
+{
+    // A Lola-2 scanner for the highlighter: it only yields the type, column and length of each
+    // token of one line, written into a buffer of the caller, and allocates nothing. Comments
+    // come as Tok_Latt, Tok_Comment and Tok_Ratt like from Lexer without packed comments.
+    class SpanLexer
+    {
+    public:
+        struct Span
+        {
+            int d_col; // 0-based; generated netlists have lines beyond 64k characters
+            int d_len;
+            quint8 d_type; // TokenType
+        };
+
+        // Scans len characters of str. Writes at most cap spans to out and returns the number of
+        // spans of the line; if that is more than cap, the caller grows the buffer and scans again.
+        // col is added to the columns, so that a scan can start in the middle of a line.
+        static int scan( const QChar* str, int len, Span* out, int cap, int col = 0 );
+
+        // convenience for buffers reused across calls; grows buf as needed
+        static int scan( const QChar* str, int len, QVector<Span>& buf, int col = 0 );
+    };
+}
+
+Q_DECLARE_TYPEINFO(Ll::SpanLexer::Span, Q_PRIMITIVE_TYPE);
+
+#endif // LLSPANLEXER_H
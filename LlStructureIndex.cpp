@@ -0,0 +1,223 @@
+/*
+* Copyright 2019 Rochus Keller <mailto:me@rochus-keller.ch>
+*
+* This file is part of the LolaCreator plugin.
+*
+* The following is the license that applies to this copy of the
+* plugin. For a license to use the plugin under conditions
+* other than those described here, please email to me@rochus-keller.ch.
+*
+* GNU General Public License Usage
+* This file may be used under the terms of the GNU General Public
+* License (GPL) versions 2.0 or 3.0 as published by the Free Software
+* Foundation and appearing in the file LICENSE.GPL included in
+* the packaging of this file. Please review the following information
+* to ensure GNU General Public Licensing requirements will be met:
+* http://www.fsf.org/licensing/licenses/info/GPLv2.html and
+* http://www.gnu.org/copyleft/gpl.html.
+*/
+
+#include "LlStructureIndex.h"
+#include <Lola/LlLexer.h>
+#include <algorithm>
+using namespace Ll;
+
+static bool isSection( const Token& t )
+{
+    switch( t.d_type )
+    {
+    case Tok_CONST:
+    case Tok_IN:
+    case Tok_INOUT:
+    case Tok_OUT:
+    case Tok_REG:
+    case Tok_VAR:
+    case Tok_TYPE:
+        return true;
+    default:
+        return false;
+    }
+}
+
+StructureIndex StructureIndex::build(const QString& text, int revision)
+{
+    StructureIndex res;
+    res.d_revision = revision;
+
+    QVector<int> lineStart;
+    lineStart.append(0);
+    for( int i = 0; i < text.size(); i++ )
+    {
+        if( text[i] == QLatin1Char('\n') )
+            lineStart.append( i + 1 );
+    }
+
+    Lexer lex;
+    const QList<Token> toks = lex.tokens(text);
+    res.d_matches = MatchTable::build( toks, lineStart, revision );
+
+    // A frame per open MODULE, BEGIN or IF. Statements are only in BEGIN and IF bodies; the
+    // statements of an IF body are inside the IF statement.
+    enum Kind { Module, Begin, If };
+    struct Frame
+    {
+        int d_block; // index in d_blocks
+        Kind d_kind;
+        int d_owner; // the IF statement, or -1
+        int d_stmt; // the open statement of the body, or -1
+        bool d_accept; // false in the condition of IF and ELSIF
+    };
+    QVector<Frame> frames;
+
+    int section = -1; // parentheses depth of the current declaration section, or -1
+    bool expectDecl = false;
+    int depth = 0;
+    int prevEnd = 0;
+
+    for( int i = 0; i < toks.size(); i++ )
+    {
+        const Token& t = toks[i];
+        if( t.d_lineNr == 0 || int(t.d_lineNr) > lineStart.size() )
+            continue;
+        const int pos = lineStart[t.d_lineNr-1] + t.d_colNr - 1;
+        const bool isIf = t.d_type == Tok_IF;
+        const bool isModule = t.d_type == Tok_MODULE;
+
+        // statements
+        const bool separator = t.d_type == Tok_Semi || t.d_type == Tok_END || t.d_type == Tok_THEN ||
+                t.d_type == Tok_ELSE || t.d_type == Tok_ELSIF;
+        if( !frames.isEmpty() && frames.last().d_kind != Module )
+        {
+            Frame& f = frames.last();
+            if( separator && f.d_stmt != -1 )
+            {
+                res.d_statements[f.d_stmt].d_end = prevEnd;
+                f.d_stmt = -1;
+            }else if( !separator && f.d_stmt == -1 && f.d_accept )
+            {
+                Range r = { pos, -1, f.d_owner };
+                f.d_stmt = res.d_statements.size();
+                res.d_statements.append(r);
+            }
+            if( f.d_kind == If )
+            {
+                if( t.d_type == Tok_THEN || t.d_type == Tok_ELSE )
+                    f.d_accept = true;
+                else if( t.d_type == Tok_ELSIF )
+                    f.d_accept = false;
+            }
+        }
+
+        // declarations
+        if( isSection(t) )
+        {
+            section = depth;
+            expectDecl = true;
+        }else if( t.d_type == Tok_Lpar )
+            depth++;
+        else if( t.d_type == Tok_Rpar )
+        {
+            if( --depth < section )
+                section = -1;
+        }else if( t.d_type == Tok_Semi )
+            expectDecl = true;
+        else if( t.d_type == Tok_identifier && section == depth && expectDecl )
+        {
+            res.d_declarations.append(pos);
+            expectDecl = false;
+        }else if( t.d_type == Tok_BEGIN || isModule || t.d_type == Tok_END )
+            section = -1;
+
+        // blocks
+        if( t.d_type == Tok_BEGIN || isIf || isModule )
+        {
+            Range r = { pos, -1, frames.isEmpty() ? -1 : frames.last().d_block };
+            Frame f;
+            f.d_block = res.d_blocks.size();
+            f.d_kind = isModule ? Module : isIf ? If : Begin;
+            f.d_owner = isIf && !frames.isEmpty() ? frames.last().d_stmt : -1;
+            f.d_stmt = -1;
+            f.d_accept = f.d_kind == Begin;
+            res.d_blocks.append(r);
+            if( isModule )
+            {
+                res.d_modules.append(pos);
+                res.d_declarations.append(pos);
+            }
+            frames.append(f);
+        }else if( t.d_type == Tok_END && !frames.isEmpty() )
+        {
+            const Frame f = frames.takeLast();
+            res.d_blocks[f.d_block].d_end = pos + t.d_len;
+            // the END of a module body also ends the module
+            if( f.d_kind == Begin && !frames.isEmpty() && frames.last().d_kind == Module )
+                res.d_blocks[frames.takeLast().d_block].d_end = pos + t.d_len;
+        }
+        prevEnd = pos + t.d_len;
+    }
+    // whatever is still open when the text ends (syntax errors) extends to the end
+    for( int i = 0; i < res.d_blocks.size(); i++ )
+        if( res.d_blocks[i].d_end == -1 )
+            res.d_blocks[i].d_end = text.size();
+    for( int i = 0; i < res.d_statements.size(); i++ )
+        if( res.d_statements[i].d_end == -1 )
+            res.d_statements[i].d_end = prevEnd;
+    return res;
+}
+
+int StructureIndex::innermost(const QVector<Range>& ranges, int pos, bool excludeStart)
+{
+    // the last range starting before pos; any range around pos is one of its ancestors
+    int i = int( std::lower_bound( ranges.begin(), ranges.end(), excludeStart ? pos : pos + 1 ) - ranges.begin() ) - 1;
+    while( i >= 0 && ranges[i].d_end < pos )
+        i = ranges[i].d_parent;
+    return i;
+}
+
+int StructureIndex::next(const QVector<int>& positions, int pos)
+{
+    QVector<int>::const_iterator i = std::upper_bound( positions.begin(), positions.end(), pos );
+    return i == positions.end() ? -1 : *i;
+}
+
+int StructureIndex::previous(const QVector<int>& positions, int pos)
+{
+    QVector<int>::const_iterator i = std::lower_bound( positions.begin(), positions.end(), pos );
+    return i == positions.begin() ? -1 : *(i-1);
+}
+
+int StructureIndex::outerBlock(int pos) const
+{
+    const int i = innermost( d_blocks, pos, true );
+    return i == -1 ? -1 : d_blocks[i].d_start;
+}
+
+int StructureIndex::nextModule(int pos) const
+{
+    return next( d_modules, pos );
+}
+
+int StructureIndex::previousModule(int pos) const
+{
+    return previous( d_modules, pos );
+}
+
+int StructureIndex::nextDeclaration(int pos) const
+{
+    return next( d_declarations, pos );
+}
+
+int StructureIndex::previousDeclaration(int pos) const
+{
+    return previous( d_declarations, pos );
+}
+
+bool StructureIndex::enclosingStatement(int pos, int& start, int& end) const
+{
+    const int i = innermost( d_statements, pos, false );
+    if( i == -1 )
+        return false;
+    start = d_statements[i].d_start;
+    end = d_statements[i].d_end;
+    return true;
+}
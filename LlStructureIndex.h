@@ -0,0 +1,70 @@
+#ifndef LLSTRUCTUREINDEX_H
+#define LLSTRUCTUREINDEX_H
+
+/*
+* Copyright 2019 Rochus Keller <mailto:me@rochus-keller.ch>
+*
+* This file is part of the LolaCreator plugin.
+*
+* The following is the license that applies to this copy of the
+* plugin. For a license to use the plugin under conditions
+* other than those described here, please email to me@rochus-keller.ch.
+*
+* GNU General Public License Usage
+* This file may be used under the terms of the GNU General Public
+* License (GPL) versions 2.0 or 3.0 as published by the Free Software
+* Foundation and appearing in the file LICENSE.GPL included in
+* the packaging of this file. Please review the following information
+* to ensure GNU General Public Licensing requirements will be met:
+* http://www.fsf.org/licensing/licenses/info/GPLv2.html and
+* http://www.gnu.org/copyleft/gpl.html.
+*/
+
+#include "LlMatchTable.h"
+#include <QVector>
+
+namespace Ll
+{
+    // Block, statement and declaration positions of a file for structural navigation. The ranges
+    // are ordered by start and properly nested, so each query is a binary search followed by a
+    // walk up the enclosing ranges. Positions are characters, ends exclusive; -1 means none.
+    class StructureIndex
+    {
+    public:
+        StructureIndex():d_revision(-1) {}
+
+        // thread safe; lexes the text once for the index and its match table
+        static StructureIndex build( const QString& text, int revision );
+
+        int outerBlock( int pos ) const; // start of the innermost MODULE, BEGIN or IF around pos
+        int nextModule( int pos ) const;
+        int previousModule( int pos ) const;
+        int nextDeclaration( int pos ) const;
+        int previousDeclaration( int pos ) const;
+        bool enclosingStatement( int pos, int& start, int& end ) const;
+
+        const MatchTable& matches() const { return d_matches; }
+        int revision() const { return d_revision; }
+
+    private:
+        struct Range
+        {
+            int d_start;
+            int d_end;
+            int d_parent; // index of the enclosing range or -1
+            bool operator<( int pos ) const { return d_start < pos; }
+        };
+        static int innermost( const QVector<Range>&, int pos, bool excludeStart );
+        static int next( const QVector<int>&, int pos );
+        static int previous( const QVector<int>&, int pos );
+
+        QVector<Range> d_blocks;
+        QVector<Range> d_statements;
+        QVector<int> d_modules;
+        QVector<int> d_declarations;
+        MatchTable d_matches;
+        int d_revision;
+    };
+}
+
+#endif // LLSTRUCTUREINDEX_H
@@ -19,6 +19,7 @@
 
 #include "LlSymbolLocator.h"
 #include "LlModelManager.h"
+#include "LlPerfMonitor.h"
 #include <Lola/LlSynTree.h>
 #include <coreplugin/editormanager/editormanager.h>
 using namespace Ll;
@@ -41,6 +42,7 @@ static bool lessThan(const Core::LocatorFilterEntry&s1, const Core::LocatorFilte
 QList<Core::LocatorFilterEntry> SymbolLocator::matchesFor(QFutureInterface<Core::LocatorFilterEntry>& future, const QString& entry)
 {
     Q_UNUSED(future);
+    ScopedTimer timer( "SymbolLocator::matchesFor", entry );
 
     QList<Core::LocatorFilterEntry> res;
 
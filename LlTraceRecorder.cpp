@@ -0,0 +1,228 @@
+/*
+* Copyright 2019 Rochus Keller <mailto:me@rochus-keller.ch>
+*
+* This file is part of the LolaCreator plugin.
+*
+* The following is the license that applies to this copy of the
+* plugin. For a license to use the plugin under conditions
+* other than those described here, please email to me@rochus-keller.ch.
+*
+* GNU General Public License Usage
+* This file may be used under the terms of the GNU General Public
+* License (GPL) versions 2.0 or 3.0 as published by the Free Software
+* Foundation and appearing in the file LICENSE.GPL included in
+* the packaging of this file. Please review the following information
+* to ensure GNU General Public Licensing requirements will be met:
+* http://www.fsf.org/licensing/licenses/info/GPLv2.html and
+* http://www.gnu.org/copyleft/gpl.html.
+*/
+
+#include "LlTraceRecorder.h"
+#include "LlPerfMonitor.h"
+#include <QCoreApplication>
+#include <QThread>
+#include <QMutex>
+#include <QHash>
+#include <QVector>
+#include <QFile>
+#include <QDir>
+#include <QDateTime>
+using namespace Ll;
+
+static const int s_maxEvents = 1000000; // about 100 MB; later events are dropped
+
+namespace
+{
+    struct Event
+    {
+        const char* d_name;
+        qint64 d_start, d_dur; // d_dur < 0 for instant events
+        int d_tid;
+        QString d_detail;
+    };
+}
+
+static QMutex s_lock;
+static QVector<Event> s_events;
+static QHash<Qt::HANDLE,int> s_threads; // thread -> small trace id
+static QHash<QByteArray,int> s_tracks;
+static QList<QString> s_threadNames;
+static QHash<int,qint64> s_lastTask; // trace id -> end of its last task
+static qint64 s_tasksQueued = 0;
+static bool s_dropped = false;
+
+static int threadId( const char* track = 0 )
+{
+    // with s_lock held
+    if( track )
+    {
+        int& id = s_tracks[ QByteArray(track) ];
+        if( id == 0 )
+        {
+            s_threadNames.append( QString::fromLatin1(track) );
+            id = s_threadNames.size();
+        }
+        return id;
+    }
+    const Qt::HANDLE h = QThread::currentThreadId();
+    QHash<Qt::HANDLE,int>::const_iterator i = s_threads.find(h);
+    if( i != s_threads.end() )
+        return i.value();
+    const int id = s_threadNames.size() + 1;
+    s_threads.insert( h, id );
+    QString name;
+    if( QCoreApplication::instance() && QThread::currentThread() == QCoreApplication::instance()->thread() )
+        name = "GUI";
+    else if( !QThread::currentThread()->objectName().isEmpty() )
+        name = QThread::currentThread()->objectName();
+    else
+        name = QString("Worker %1").arg(id);
+    s_threadNames.append(name);
+    return id;
+}
+
+static void add( const char* name, qint64 start, qint64 dur, const QString& detail, const char* track = 0 )
+{
+    // with s_lock held
+    if( !PerfMonitor::isEnabled(PerfMonitor::Tracing) )
+        return; // stopped meanwhile
+    if( s_events.size() >= s_maxEvents )
+    {
+        s_dropped = true;
+        return;
+    }
+    Event e;
+    e.d_name = name;
+    e.d_start = start;
+    e.d_dur = dur;
+    e.d_tid = threadId(track);
+    e.d_detail = detail;
+    s_events.append(e);
+}
+
+void TraceRecorder::start()
+{
+    QMutexLocker guard(&s_lock);
+    s_events.clear();
+    s_threads.clear();
+    s_tracks.clear();
+    s_threadNames.clear();
+    s_lastTask.clear();
+    s_dropped = false;
+    PerfMonitor::setFlag( PerfMonitor::Tracing, true );
+}
+
+bool TraceRecorder::isRecording()
+{
+    return PerfMonitor::isEnabled(PerfMonitor::Tracing);
+}
+
+void TraceRecorder::complete(const char* name, qint64 start, qint64 nsecs, const QString& detail, const char* track)
+{
+    QMutexLocker guard(&s_lock);
+    add( name, start, nsecs, detail, track );
+}
+
+void TraceRecorder::instant(const char* name, const QString& detail)
+{
+    if( !isRecording() )
+        return;
+    QMutexLocker guard(&s_lock);
+    add( name, PerfMonitor::now(), -1, detail );
+}
+
+void TraceRecorder::tasksQueued()
+{
+    if( !isRecording() )
+        return;
+    QMutexLocker guard(&s_lock);
+    s_tasksQueued = PerfMonitor::now();
+}
+
+void TraceRecorder::taskDone(const char* name, const QString& detail)
+{
+    if( !isRecording() )
+        return;
+    QMutexLocker guard(&s_lock);
+    const qint64 now = PerfMonitor::now();
+    const int tid = threadId();
+    const qint64 start = qMax( s_lastTask.value(tid), s_tasksQueued );
+    s_lastTask[tid] = now;
+    add( name, start, now - start, detail );
+}
+
+static QByteArray quoted( const QString& str )
+{
+    QByteArray res = "\"";
+    const QByteArray utf8 = str.toUtf8();
+    for( int i = 0; i < utf8.size(); i++ )
+    {
+        const char c = utf8[i];
+        switch( c )
+        {
+        case '"':
+            res += "\\\"";
+            break;
+        case '\\':
+            res += "\\\\";
+            break;
+        case '\n':
+            res += "\\n";
+            break;
+        case '\t':
+            res += "\\t";
+            break;
+        default:
+            if( uchar(c) < 0x20 )
+                res += QByteArray("\\u00") + QByteArray::number( uchar(c), 16 ).rightJustified( 2, '0' );
+            else
+                res += c;
+        }
+    }
+    res += '"';
+    return res;
+}
+
+static QByteArray micros( qint64 nsecs )
+{
+    return QByteArray::number( nsecs / 1000.0, 'f', 3 );
+}
+
+QString TraceRecorder::stop()
+{
+    QMutexLocker guard(&s_lock);
+    PerfMonitor::setFlag( PerfMonitor::Tracing, false );
+
+    const QString path = QDir::temp().absoluteFilePath(
+                QString("lola-trace-%1.json").arg( QDateTime::currentDateTime().toString("yyyyMMdd-hhmmss") ) );
+    QFile out(path);
+    if( !out.open(QIODevice::WriteOnly) )
+        return QString();
+
+    const QByteArray pid = QByteArray::number( QCoreApplication::applicationPid() );
+    out.write( "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n" );
+    out.write( "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" + pid + ",\"args\":{\"name\":\"QtCreator Lola\"}}" );
+    for( int i = 0; i < s_threadNames.size(); i++ )
+        out.write( ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" + pid + ",\"tid\":" + QByteArray::number(i+1) +
+                   ",\"args\":{\"name\":" + quoted(s_threadNames[i]) + "}}" );
+    foreach( const Event& e, s_events )
+    {
+        QByteArray line = ",\n{\"name\":" + quoted( QString::fromLatin1(e.d_name) ) + ",\"cat\":\"lola\"";
+        if( e.d_dur < 0 )
+            line += ",\"ph\":\"i\",\"s\":\"t\"";
+        else
+            line += ",\"ph\":\"X\",\"dur\":" + micros(e.d_dur);
+        line += ",\"ts\":" + micros(e.d_start) + ",\"pid\":" + pid + ",\"tid\":" + QByteArray::number(e.d_tid);
+        if( !e.d_detail.isEmpty() )
+            line += ",\"args\":{\"detail\":" + quoted(e.d_detail) + "}";
+        line += "}";
+        out.write( line );
+    }
+    if( s_dropped )
+        out.write( ",\n{\"name\":\"trace buffer full, later events dropped\",\"ph\":\"i\",\"s\":\"g\",\"ts\":" +
+                   micros( s_events.isEmpty() ? 0 : s_events.last().d_start ) + ",\"pid\":" + pid + "}" );
+    out.write( "\n]}\n" );
+    s_events.clear();
+    s_events.squeeze();
+    return out.error() == QFile::NoError ? path : QString();
+}
@@ -0,0 +1,52 @@
+#ifndef LLTRACERECORDER_H
+#define LLTRACERECORDER_H
+
+/*
+* Copyright 2019 Rochus Keller <mailto:me@rochus-keller.ch>
+*
+* This file is part of the LolaCreator plugin.
+*
+* The following is the license that applies to this copy of the
+* plugin. For a license to use the plugin under conditions
+* other than those described here, please email to me@rochus-keller.ch.
+*
+* GNU General Public License Usage
+* This file may be used under the terms of the GNU General Public
+* License (GPL) versions 2.0 or 3.0 as published by the Free Software
+* Foundation and appearing in the file LICENSE.GPL included in
+* the packaging of this file. Please review the following information
+* to ensure GNU General Public Licensing requirements will be met:
+* http://www.fsf.org/licensing/licenses/info/GPLv2.html and
+* http://www.gnu.org/copyleft/gpl.html.
+*/
+
+#include <QString>
+
+namespace Ll
+{
+    // Records the PerfMonitor samples and single events as Chrome trace events (chrome://tracing,
+    // ui.perfetto.dev), with the thread they happened on
+    class TraceRecorder
+    {
+    public:
+        static void start();
+        // stops recording and writes the trace to the temp directory; returns the file path or
+        // an empty string if it could not be written
+        static QString stop();
+        static bool isRecording();
+
+        // name and track must be string literals; times are PerfMonitor::now() nanoseconds. Events
+        // are shown on the row of the calling thread, or on the named track for asynchronous spans.
+        static void complete( const char* name, qint64 start, qint64 nsecs, const QString& detail = QString(),
+                              const char* track = 0 );
+        static void instant( const char* name, const QString& detail = QString() );
+        // Spans of work items done one after the other by background threads: taskDone ends a span
+        // which began with the previous taskDone on the same thread, or with tasksQueued if later
+        static void tasksQueued();
+        static void taskDone( const char* name, const QString& detail = QString() );
+    private:
+        TraceRecorder() {}
+    };
+}
+
+#endif // LLTRACERECORDER_H
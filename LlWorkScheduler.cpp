@@ -0,0 +1,161 @@
+/*
+* Copyright 2019 Rochus Keller <mailto:me@rochus-keller.ch>
+*
+* This file is part of the LolaCreator plugin.
+*
+* The following is the license that applies to this copy of the
+* plugin. For a license to use the plugin under conditions
+* other than those described here, please email to me@rochus-keller.ch.
+*
+* GNU General Public License Usage
+* This file may be used under the terms of the GNU General Public
+* License (GPL) versions 2.0 or 3.0 as published by the Free Software
+* Foundation and appearing in the file LICENSE.GPL included in
+* the packaging of this file. Please review the following information
+* to ensure GNU General Public Licensing requirements will be met:
+* http://www.fsf.org/licensing/licenses/info/GPLv2.html and
+* http://www.gnu.org/copyleft/gpl.html.
+*/
+
+#include "LlWorkScheduler.h"
+#include <QPlainTextEdit>
+#include <QScrollBar>
+#include <QElapsedTimer>
+#include <QTextBlock>
+using namespace Ll;
+
+static const int s_sliceBlocks = 100;
+static const int s_idleBudgetMs = 8; // per idle round, so typing stays responsive
+
+WorkScheduler::WorkScheduler(QPlainTextEdit* editor):QObject(editor),d_gen(0),d_editor(editor)
+{
+    d_idle.setSingleShot(true);
+    d_idle.setInterval(0);
+    connect( &d_idle, SIGNAL(timeout()), this, SLOT(onIdle()) );
+    connect( editor->verticalScrollBar(), SIGNAL(valueChanged(int)), this, SLOT(onScrolled()) );
+}
+
+void WorkScheduler::schedule(int id, const Job& job, const Flush& flush)
+{
+    Task& t = d_tasks[id];
+    t.d_job = job;
+    t.d_flush = flush;
+    const int slices = ( d_editor->document()->blockCount() + s_sliceBlocks - 1 ) / s_sliceBlocks;
+    t.d_done = QBitArray( slices );
+    t.d_shown = QBitArray( slices );
+    t.d_left = slices;
+    t.d_gen = ++d_gen;
+    runVisible(id);
+    if( !d_tasks.isEmpty() )
+        d_idle.start();
+}
+
+void WorkScheduler::cancel(int id)
+{
+    d_tasks.remove(id);
+}
+
+void WorkScheduler::visibleRange(int& from, int& to) const
+{
+    const QRect r = d_editor->viewport()->rect();
+    from = d_editor->cursorForPosition( r.topLeft() ).blockNumber();
+    to = d_editor->cursorForPosition( r.bottomLeft() ).blockNumber() + 1;
+}
+
+bool WorkScheduler::run(Task& t, int from, int to)
+{
+    bool ran = false;
+    const int last = qMin( ( to + s_sliceBlocks - 1 ) / s_sliceBlocks, t.d_done.size() );
+    for( int s = qMax( 0, from / s_sliceBlocks ); s < last; s++ )
+    {
+        if( t.d_done.testBit(s) )
+            continue;
+        t.d_job( s * s_sliceBlocks, ( s + 1 ) * s_sliceBlocks );
+        t.d_done.setBit(s);
+        t.d_left--;
+        ran = true;
+    }
+    return ran;
+}
+
+int WorkScheduler::nextSlice(const Task& t) const
+{
+    // continue below the viewport, where the user most likely goes next, then wrap around
+    int from, to;
+    visibleRange( from, to );
+    const int n = t.d_done.size();
+    const int first = qMin( from / s_sliceBlocks, n );
+    for( int i = 0; i < n; i++ )
+    {
+        const int s = ( first + i ) % n;
+        if( !t.d_done.testBit(s) )
+            return s;
+    }
+    return -1;
+}
+
+void WorkScheduler::store(int id, const Task& t)
+{
+    // the job or its flush may have rescheduled or cancelled the task meanwhile
+    QMap<int,Task>::iterator i = d_tasks.find(id);
+    if( i == d_tasks.end() || i.value().d_gen != t.d_gen )
+        return;
+    if( t.d_left <= 0 )
+        d_tasks.erase(i);
+    else
+        i.value() = t;
+}
+
+void WorkScheduler::runVisible(int id)
+{
+    if( !d_tasks.contains(id) )
+        return;
+    int from, to;
+    visibleRange( from, to );
+    Task t = d_tasks.value(id);
+    run( t, from, to );
+    // slices done at idle time are only applied when they become visible or all are done
+    bool unshown = t.d_left <= 0;
+    const int last = qMin( ( to + s_sliceBlocks - 1 ) / s_sliceBlocks, t.d_done.size() );
+    for( int s = qMax( 0, from / s_sliceBlocks ); s < last && !unshown; s++ )
+        unshown = t.d_done.testBit(s) && !t.d_shown.testBit(s);
+    if( unshown )
+        flush( t );
+    store( id, t );
+}
+
+void WorkScheduler::flush(Task& t)
+{
+    t.d_shown = t.d_done;
+    if( t.d_flush )
+        t.d_flush();
+}
+
+void WorkScheduler::onIdle()
+{
+    QElapsedTimer timer;
+    timer.start();
+    while( !d_tasks.isEmpty() && timer.elapsed() < s_idleBudgetMs )
+    {
+        const int id = d_tasks.firstKey();
+        Task t = d_tasks.first();
+        int s;
+        while( ( s = nextSlice(t) ) != -1 )
+        {
+            run( t, s * s_sliceBlocks, ( s + 1 ) * s_sliceBlocks );
+            if( timer.elapsed() >= s_idleBudgetMs )
+                break;
+        }
+        if( t.d_left <= 0 )
+            flush( t );
+        store( id, t );
+    }
+    if( !d_tasks.isEmpty() )
+        d_idle.start();
+}
+
+void WorkScheduler::onScrolled()
+{
+    foreach( int id, d_tasks.keys() )
+        runVisible(id);
+}
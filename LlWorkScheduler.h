@@ -0,0 +1,81 @@
+#ifndef LLWORKSCHEDULER_H
+#define LLWORKSCHEDULER_H
+
+/*
+* Copyright 2019 Rochus Keller <mailto:me@rochus-keller.ch>
+*
+* This file is part of the LolaCreator plugin.
+*
+* The following is the license that applies to this copy of the
+* plugin. For a license to use the plugin under conditions
+* other than those described here, please email to me@rochus-keller.ch.
+*
+* GNU General Public License Usage
+* This file may be used under the terms of the GNU General Public
+* License (GPL) versions 2.0 or 3.0 as published by the Free Software
+* Foundation and appearing in the file LICENSE.GPL included in
+* the packaging of this file. Please review the following information
+* to ensure GNU General Public Licensing requirements will be met:
+* http://www.fsf.org/licensing/licenses/info/GPLv2.html and
+* http://www.gnu.org/copyleft/gpl.html.
+*/
+
+#include <QObject>
+#include <QTimer>
+#include <QBitArray>
+#include <QMap>
+#include <functional>
+
+class QPlainTextEdit;
+
+namespace Ll
+{
+    // Runs per-document work in slices of blocks: the visible blocks right away, the rest of
+    // the document at idle priority, and newly visible blocks first when the user scrolls.
+    class WorkScheduler : public QObject
+    {
+        Q_OBJECT
+    public:
+        typedef std::function<void(int from, int to)> Job; // block numbers, to is exclusive
+        // applies what the slices produced so far; called when slices in the viewport are done
+        // which were not yet applied, and once when all slices are done
+        typedef std::function<void()> Flush;
+
+        explicit WorkScheduler( QPlainTextEdit* );
+
+        // replaces a pending job with the same id
+        void schedule( int id, const Job&, const Flush& = Flush() );
+        void cancel( int id );
+        bool isPending( int id ) const { return d_tasks.contains(id); }
+
+        void visibleRange( int& from, int& to ) const;
+
+    protected slots:
+        void onIdle();
+        void onScrolled();
+
+    protected:
+        struct Task
+        {
+            Job d_job;
+            Flush d_flush;
+            QBitArray d_done; // per slice
+            QBitArray d_shown; // per slice, done and flushed
+            int d_left;
+            quint32 d_gen;
+        };
+        bool run( Task&, int from, int to ); // the slices overlapping from..to not yet done
+        int nextSlice( const Task& ) const;
+        void store( int id, const Task& );
+        void runVisible( int id );
+        void flush( Task& );
+
+    private:
+        QMap<int,Task> d_tasks;
+        quint32 d_gen;
+        QTimer d_idle;
+        QPlainTextEdit* d_editor;
+    };
+}
+
+#endif // LLWORKSCHEDULER_H
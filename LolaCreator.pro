@@ -19,6 +19,8 @@
 
 DEFINES += LOLACREATOR_LIBRARY
 
+QT += concurrent
+
 # Qt Creator linking
 
 ## set the QTC_SOURCE environment variable to override the setting here
@@ -85,7 +87,9 @@ CONFIG(debug, debug|release) {
 
 INCLUDEPATH += ..
 
-# LolaCreator files
+# LolaCreator files; the indexing core is shared with lolaindex.pro
+
+include( Indexer.pri )
 
 SOURCES += LolaCreatorPlugin.cpp \
     LlModelManager.cpp \
@@ -96,11 +100,17 @@ SOURCES += LolaCreatorPlugin.cpp \
     LlHoverHandler.cpp \
     LlModuleLocator.cpp \
     LlSymbolLocator.cpp \
-    LlProjectFile.cpp \
     LlProject.cpp \
     LlIndenter.cpp \
     LlAutoCompleter.cpp \
-    LlCompletionAssistProvider.cpp
+    LlCompletionAssistProvider.cpp \
+    LlPerfMonitor.cpp \
+    LlPerfPane.cpp \
+    LlTraceRecorder.cpp \
+    LlSemanticHighlighter.cpp \
+    LlWorkScheduler.cpp \
+    LlMatchTable.cpp \
+    LlStructureIndex.cpp
 
 HEADERS += LolaCreatorPlugin.h \
         LolaCreatorGlobal.h \
@@ -113,11 +123,17 @@ HEADERS += LolaCreatorPlugin.h \
     LlHoverHandler.h \
     LlModuleLocator.h \
     LlSymbolLocator.h \
-    LlProjectFile.h \
     LlProject.h \
     LlIndenter.h \
     LlAutoCompleter.h \
-    LlCompletionAssistProvider.h
+    LlCompletionAssistProvider.h \
+    LlPerfMonitor.h \
+    LlPerfPane.h \
+    LlTraceRecorder.h \
+    LlSemanticHighlighter.h \
+    LlWorkScheduler.h \
+    LlMatchTable.h \
+    LlStructureIndex.h
 
 include (../Lola/Lola.pri )
 
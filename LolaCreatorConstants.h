@@ -27,18 +27,29 @@ const char LangLola[] = "Lola-2";
 const char LangQmake[] = "Qmake";
 const char EditorId1[] = "Lola.Editor";
 const char TaskId[] = "Lola.TaskId";
+const char LoadTaskId[] = "Lola.LoadProject";
 const char EditorDisplayName1[] = "Lola Editor";
 const char EditorId2[] = "Lola.Project.Editor";
 const char EditorDisplayName2[] = "Lola Project Editor";
 const char MimeType[] = "text/x-lola";
 const char ProjectMimeType[] = "text/x-lolacreator-project";
 const char SettingsId[] = "Lola.Settings";
+const char SettingsGroup[] = "LolaCreator";
 const char EditorContextMenuId1[] = "LolaEditor.ContextMenu";
 const char EditorContextMenuId2[] = "LolaProjectEditor.ContextMenu";
 const char ToolsMenuId[] = "LolaTools.ToolsMenu";
 const char FindUsagesCmd[] = "LolaEditor.FindUsages";
 const char GotoOuterBlockCmd[] = "LolaEditor.GotoOuterBlockCmd";
+const char GotoMatchingCmd[] = "LolaEditor.GotoMatchingCmd";
+const char GotoBlockEndCmd[] = "LolaEditor.GotoBlockEndCmd";
+const char GotoNextModuleCmd[] = "LolaEditor.GotoNextModuleCmd";
+const char GotoPreviousModuleCmd[] = "LolaEditor.GotoPreviousModuleCmd";
+const char GotoNextDeclCmd[] = "LolaEditor.GotoNextDeclCmd";
+const char GotoPreviousDeclCmd[] = "LolaEditor.GotoPreviousDeclCmd";
+const char SelectStatementCmd[] = "LolaEditor.SelectStatementCmd";
 const char ReloadProjectCmd[] = "LolaEditor.ReloadProjectCmd";
+const char RecordPerfCmd[] = "LolaEditor.RecordPerfCmd";
+const char RecordTraceCmd[] = "LolaEditor.RecordTraceCmd";
 
 } // namespace LolaCreator
 } // namespace Constants
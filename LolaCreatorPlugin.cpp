@@ -25,6 +25,8 @@
 #include "LlModuleLocator.h"
 #include "LlSymbolLocator.h"
 #include "LlProject.h"
+#include "LlProjectFile.h"
+#include "LlPerfPane.h"
 
 #include <coreplugin/icore.h>
 #include <coreplugin/icontext.h>
@@ -44,6 +46,7 @@
 #include <QMessageBox>
 #include <QMainWindow>
 #include <QMenu>
+#include <QSettings>
 
 #include <QtPlugin>
 #include <QtDebug>
@@ -69,6 +72,14 @@ bool LolaCreatorPlugin::initialize(const QStringList &arguments, QString *errorS
 
     Ll::ModelManager::instance();
 
+    QSettings* settings = Core::ICore::settings();
+    settings->beginGroup(QLatin1String(LolaCreator::Constants::SettingsGroup));
+    Ll::ModelManager::instance()->setIdleBudget( settings->value("IdleModels", 3).toInt(),
+                                                 settings->value("IdleModelBytes", 16*1024*1024).toLongLong() );
+    Ll::ProjectFile::setSystemCacheLifetime( settings->value("SystemCacheSecs", 60).toInt() );
+    Ll::EditorDocument1::setLargeFileThreshold( settings->value("LargeFileBytes", 8*1024*1024).toLongLong() );
+    settings->endGroup();
+
     initializeToolsSettings();
 
     addAutoReleasedObject(new Ll::EditorFactory1);
@@ -76,6 +87,8 @@ bool LolaCreatorPlugin::initialize(const QStringList &arguments, QString *errorS
     addAutoReleasedObject(new Ll::ModuleLocator);
     addAutoReleasedObject(new Ll::SymbolLocator);
     addAutoReleasedObject(new Ll::ProjectManager);
+    Ll::PerfPane* perfPane = new Ll::PerfPane;
+    addAutoReleasedObject(perfPane);
     /*
     addAutoReleasedObject(new Vl::OutlineWidgetFactory);
     addAutoReleasedObject(new Vl::MakeStepFactory);
@@ -110,6 +123,54 @@ bool LolaCreatorPlugin::initialize(const QStringList &arguments, QString *errorS
     contextMenu1->addAction(cmd);
     toolsMenu->addAction(cmd);
 
+    d_gotoMatchingAction = new QAction(tr("Go to Matching BEGIN/END or Bracket"), this);
+    cmd = Core::ActionManager::registerAction(d_gotoMatchingAction, LolaCreator::Constants::GotoMatchingCmd, context);
+    cmd->setDefaultKeySequence(QKeySequence(tr("Ctrl+Shift+M")));
+    connect(d_gotoMatchingAction, SIGNAL(triggered()), this, SLOT(onGotoMatching()));
+    contextMenu1->addAction(cmd);
+    toolsMenu->addAction(cmd);
+
+    d_gotoBlockEndAction = new QAction(tr("Go to Block End"), this);
+    cmd = Core::ActionManager::registerAction(d_gotoBlockEndAction, LolaCreator::Constants::GotoBlockEndCmd, context);
+    cmd->setDefaultKeySequence(QKeySequence(tr("Ctrl+Shift+E")));
+    connect(d_gotoBlockEndAction, SIGNAL(triggered()), this, SLOT(onGotoBlockEnd()));
+    contextMenu1->addAction(cmd);
+    toolsMenu->addAction(cmd);
+
+    d_gotoNextModuleAction = new QAction(tr("Go to Next Module"), this);
+    cmd = Core::ActionManager::registerAction(d_gotoNextModuleAction, LolaCreator::Constants::GotoNextModuleCmd, context);
+    connect(d_gotoNextModuleAction, SIGNAL(triggered()), this, SLOT(onGotoNextModule()));
+    toolsMenu->addAction(cmd);
+
+    d_gotoPreviousModuleAction = new QAction(tr("Go to Previous Module"), this);
+    cmd = Core::ActionManager::registerAction(d_gotoPreviousModuleAction, LolaCreator::Constants::GotoPreviousModuleCmd, context);
+    connect(d_gotoPreviousModuleAction, SIGNAL(triggered()), this, SLOT(onGotoPreviousModule()));
+    toolsMenu->addAction(cmd);
+
+    d_gotoNextDeclAction = new QAction(tr("Go to Next Declaration"), this);
+    cmd = Core::ActionManager::registerAction(d_gotoNextDeclAction, LolaCreator::Constants::GotoNextDeclCmd, context);
+    cmd->setDefaultKeySequence(QKeySequence(tr("ALT+Down")));
+    connect(d_gotoNextDeclAction, SIGNAL(triggered()), this, SLOT(onGotoNextDeclaration()));
+    toolsMenu->addAction(cmd);
+
+    d_gotoPreviousDeclAction = new QAction(tr("Go to Previous Declaration"), this);
+    cmd = Core::ActionManager::registerAction(d_gotoPreviousDeclAction, LolaCreator::Constants::GotoPreviousDeclCmd, context);
+    connect(d_gotoPreviousDeclAction, SIGNAL(triggered()), this, SLOT(onGotoPreviousDeclaration()));
+    toolsMenu->addAction(cmd);
+
+    d_selectStatementAction = new QAction(tr("Select Enclosing Statement"), this);
+    cmd = Core::ActionManager::registerAction(d_selectStatementAction, LolaCreator::Constants::SelectStatementCmd, context);
+    connect(d_selectStatementAction, SIGNAL(triggered()), this, SLOT(onSelectEnclosingStatement()));
+    toolsMenu->addAction(cmd);
+
+    cmd = Core::ActionManager::registerAction(perfPane->recordAction(), LolaCreator::Constants::RecordPerfCmd,
+                                              Core::Context(Core::Constants::C_GLOBAL));
+    toolsMenu->addSeparator();
+    toolsMenu->addAction(cmd);
+    cmd = Core::ActionManager::registerAction(perfPane->traceAction(), LolaCreator::Constants::RecordTraceCmd,
+                                              Core::Context(Core::Constants::C_GLOBAL));
+    toolsMenu->addAction(cmd);
+
     Core::Command *sep = contextMenu1->addSeparator();
 
     cmd = Core::ActionManager::command(TextEditor::Constants::AUTO_INDENT_SELECTION);
@@ -156,6 +217,48 @@ void LolaCreatorPlugin::onGotoOuterBlock()
         editorWidget->onGotoOuterBlock();
 }
 
+void LolaCreatorPlugin::onGotoMatching()
+{
+    if (Ll::EditorWidget1 *editorWidget = currentEditorWidget())
+        editorWidget->onGotoMatching();
+}
+
+void LolaCreatorPlugin::onGotoBlockEnd()
+{
+    if (Ll::EditorWidget1 *editorWidget = currentEditorWidget())
+        editorWidget->onGotoBlockEnd();
+}
+
+void LolaCreatorPlugin::onGotoNextModule()
+{
+    if (Ll::EditorWidget1 *editorWidget = currentEditorWidget())
+        editorWidget->onGotoNextModule();
+}
+
+void LolaCreatorPlugin::onGotoPreviousModule()
+{
+    if (Ll::EditorWidget1 *editorWidget = currentEditorWidget())
+        editorWidget->onGotoPreviousModule();
+}
+
+void LolaCreatorPlugin::onGotoNextDeclaration()
+{
+    if (Ll::EditorWidget1 *editorWidget = currentEditorWidget())
+        editorWidget->onGotoNextDeclaration();
+}
+
+void LolaCreatorPlugin::onGotoPreviousDeclaration()
+{
+    if (Ll::EditorWidget1 *editorWidget = currentEditorWidget())
+        editorWidget->onGotoPreviousDeclaration();
+}
+
+void LolaCreatorPlugin::onSelectEnclosingStatement()
+{
+    if (Ll::EditorWidget1 *editorWidget = currentEditorWidget())
+        editorWidget->onSelectEnclosingStatement();
+}
+
 void LolaCreatorPlugin::onReloadProject()
 {
     Ll::Project* currentProject = dynamic_cast<Ll::Project*>( ProjectExplorer::ProjectTree::currentProject() );
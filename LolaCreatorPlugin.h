@@ -48,6 +48,13 @@ namespace LolaCreator {
         public slots:
             void onFindUsages();
             void onGotoOuterBlock();
+            void onGotoMatching();
+            void onGotoBlockEnd();
+            void onGotoNextModule();
+            void onGotoPreviousModule();
+            void onGotoNextDeclaration();
+            void onGotoPreviousDeclaration();
+            void onSelectEnclosingStatement();
             void onReloadProject();
 
         protected:
@@ -57,6 +64,13 @@ namespace LolaCreator {
         private:
             QAction* d_findUsagesAction;
             QAction* d_gotoOuterBlockAction;
+            QAction* d_gotoMatchingAction;
+            QAction* d_gotoBlockEndAction;
+            QAction* d_gotoNextModuleAction;
+            QAction* d_gotoPreviousModuleAction;
+            QAction* d_gotoNextDeclAction;
+            QAction* d_gotoPreviousDeclAction;
+            QAction* d_selectStatementAction;
             QAction* d_reloadProject;
         };
 
@@ -0,0 +1,51 @@
+#/*
+#* Copyright 2019 Rochus Keller <mailto:me@rochus-keller.ch>
+#*
+#* This file is part of the LolaCreator plugin.
+#*
+#* The following is the license that applies to this copy of the
+#* plugin. For a license to use the plugin under conditions
+#* other than those described here, please email to me@rochus-keller.ch.
+#*
+#* GNU General Public License Usage
+#* This file may be used under the terms of the GNU General Public
+#* License (GPL) versions 2.0 or 3.0 as published by the Free Software
+#* Foundation and appearing in the file LICENSE.GPL included in
+#* the packaging of this file. Please review the following information
+#* to ensure GNU General Public Licensing requirements will be met:
+#* http://www.fsf.org/licensing/licenses/info/GPLv2.html and
+#* http://www.gnu.org/copyleft/gpl.html.
+#*/
+
+# Command line indexer: loads an llpro file, builds the cross-reference model and prints
+# the diagnostics and timing. Needs neither QtCreator nor QtGui.
+
+TEMPLATE = app
+TARGET = lolaindex
+QT = core
+CONFIG += console
+CONFIG -= app_bundle
+
+CONFIG(debug, debug|release) {
+        DEFINES += _DEBUG
+}
+!win32 { QMAKE_CXXFLAGS += -Wno-reorder -Wno-unused-parameter -Wno-unused-function -Wno-unused-variable }
+
+INCLUDEPATH += ..
+
+include( Indexer.pri )
+
+SOURCES += LlIndexMain.cpp \
+    LlBenchmark.cpp
+
+HEADERS += LlBenchmark.h
+
+include (../Lola/Lola.pri )
+
+# make perfcheck runs the benchmarks on the corpus recorded in perf/baseline.json and fails
+# on regressions; make perfcheck-update records a new baseline on the reference machine
+perfcheck.commands = $$shell_path($$OUT_PWD/$$TARGET) --bench --check $$shell_path($$PWD/perf/baseline.json)
+perfcheck.depends = $(TARGET)
+perfcheck-update.commands = $$perfcheck.commands --update-baseline
+perfcheck-update.depends = $(TARGET)
+QMAKE_EXTRA_TARGETS += perfcheck perfcheck-update